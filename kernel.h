@@ -1,11 +1,30 @@
-#define DEBUG 0
-
 typedef struct proc_struct proc_struct;
 
+/* Per-process scheduling statistics, see get_proc_stats().  Times are in
+ * microseconds.
+ */
+typedef struct proc_stats proc_stats;
+
+struct proc_stats {
+   int            cpu_time;          /* time RUNNING */
+   int            ready_time;        /* time READY, waiting for the cpu */
+   int            blocked_time;      /* time BLOCKED, not counting throttled_time */
+   int            throttled_time;    /* time parked by its group's cpu quota */
+   int            vol_switches;      /* gave up the cpu: blocked, quit or yield() */
+   int            invol_switches;    /* preempted or throttled while it could still run */
+   int            throttles;         /* times its group's cpu quota parked it */
+   int            forks;             /* children forked */
+   int            zapped;            /* times another process zapped it */
+   int            wakeups;           /* times it went from BLOCKED to READY */
+   int            wake_latency;      /* summed time from a wakeup until it ran */
+   int            max_wake_latency;  /* longest of those */
+};
+
 typedef struct proc_struct * proc_ptr;
 
 struct proc_struct {
    proc_ptr       next_proc_ptr;
+   proc_ptr       prev_proc_ptr;     /* back link on the ReadyList */
    proc_ptr       child_proc_ptr;
    proc_ptr       next_sibling_ptr;
    proc_ptr       parent_ptr;
@@ -13,7 +32,14 @@ struct proc_struct {
    char           start_arg[MAXARG]; /* args passed to process */
    context        state;             /* current context for process */
    short          pid;               /* process id */
-   int            priority;
+   int            priority;          /* base priority */
+   int            eff_priority;      /* priority the process is queued at */
+   int            inh_priority;      /* best priority of processes waiting on it */
+   int            ready_since;       /* sys_clock() when it was queued, reset by aging */
+   int            queued_at;         /* sys_clock() when it last became READY, see get_latency() */
+   int            rl_rank;           /* RANK_* it was queued with */
+   proc_ptr       next_age_ptr;      /* arrival order on the ReadyList, see prio_age() */
+   proc_ptr       prev_age_ptr;
    int (* start_func) (char *);      /* function where process begins -- launch */
    char          *stack;
    unsigned int   stacksize;
@@ -21,11 +47,46 @@ struct proc_struct {
    int            is_zapped;         /* ZAPPED, NOT_ZAPPED */
    proc_ptr       zapped_by_ptr;
    proc_ptr       next_zapper_ptr;
+   proc_ptr       zap_target;        /* process it is waiting on in zap() */
+   int            lends;             /* lends its priority in join() and zap() */
+   int            batch;             /* long quantum, no wakeup preemption by batch */
+   proc_ptr       group;             /* leader of its group, a child of start1 */
+   int            group_cpu;         /* cpu microseconds used by the group (leader only) */
+   long long      group_pass;        /* fair policy virtual time of the group (leader only) */
+   int            quota;             /* group cpu microseconds per quota period, 0 if none */
+   int            quota_period;      /* quota period in microseconds */
+   int            quota_start;       /* sys_clock() when the current period began */
+   int            quota_base;        /* group cpu used before the current period */
+   int            throttled;         /* group is parked until the next period */
+   int            throttle_since;    /* sys_clock() when it was parked */
+   int            throttle_events;   /* times the group ran out of quota */
+   int            throttled_time;    /* microseconds spent parked */
    int            exit_code;         /* exit code of process when it calls quit */
    int            blocked_status;    /* indicates how something was blocked */
    int            start_time;        /* records the start time in microseconds */
    int            num_kids;          /* keeps count of number of children process has */
-   int            pc_time;           /* running total amount of  pc_time process has had in processor */
+   int            pc_time;           /* running total of cpu time in microseconds, up to start_time */
+   int            slice_left;        /* microseconds of the quantum left at start_time */
+   int            run_since;         /* sys_clock() when it got the cpu or a new quantum */
+   int            quantum;           /* adaptive time slice in microseconds */
+   int            slice_ema;         /* moving average of the cpu used per slice */
+   int            prof_ticks;        /* clock ticks sampled while it was Current */
+   proc_stats     stats;             /* all but cpu_time kept up to stat_since */
+   int            stat_since;        /* sys_clock() when it became READY or BLOCKED */
+   int            woken;             /* READY because of a wakeup, not yet run */
+   int            tickets;           /* proportional share of the cpu (stride policy) */
+   int            stride;            /* STRIDE1 / tickets */
+   long long      pass;              /* stride virtual time, lowest pass runs next */
+   int            pass_cpu;          /* pc_time up to which pass has been charged */
+   int            pass_rem;          /* stride * cpu below one unit of pass, kept for the next charge */
+   int            heap_index;        /* 1-based slot in the stride heap, 0 if not queued */
+   int            edf_period;        /* real-time period in microseconds, 0 if none */
+   int            edf_budget;        /* cpu microseconds allowed per period */
+   int            edf_left;          /* budget left in the current period */
+   int            edf_deadline;      /* sys_clock() at which the period ends */
+   int            edf_cpu;           /* pc_time up to which the budget has been charged */
+   int            edf_throttled;     /* budget used up, parked until next period */
+   int            deadline_misses;   /* periods that ended with budget unused */
    /* other fields as needed... */
 };
 
@@ -54,4 +115,194 @@ union psr_values {
 #define QUIT 3
 #define NOT_ZAPPED 0
 #define ZAPPED 1
+#define JOIN_BLOCK 1             /* blocked_status while waiting in join() */
+#define ZAP_BLOCK 2              /* blocked_status while waiting in zap() */
+#define THROTTLE_BLOCK 3         /* blocked_status while its group is over quota */
+#define NO_INHERIT (LOWEST_PRIORITY + 1) /* inh_priority when nobody waits */
+#define QUANTUM 80000            /* time slice in microseconds */
+#define WAKEUP_GRANULARITY QUANTUM /* see set_wakeup_granularity() */
+#define AGE_INTERVAL (5 * QUANTUM) /* READY this long raises a priority by one */
+#define BATCH_QUANTUM (10 * QUANTUM) /* time slice of a batch process */
+#define MIN_QUANTUM (QUANTUM / 4)  /* adaptive quantum bounds, see quantum_update() */
+#define MAX_QUANTUM (4 * QUANTUM)
+#define QUANTUM_EMA_WEIGHT 8     /* a slice moves the average 1/8 of the way */
+
+/* order inside one ReadyList, see rl_rank() */
+#define RANK_SHORT 0             /* quantum below QUANTUM: it blocks early */
+#define RANK_NORMAL 1
+#define RANK_BATCH 2
+#define RL_RANKS 3
+
+/* Scheduler operations table.  Every scheduling policy fills one of these
+ * in; the rest of the kernel only talks to the policy through it.
+ */
+typedef struct sched_ops sched_ops;
+
+struct sched_ops {
+   char      *name;                   /* selected by name at startup */
+   void     (*init)(void);            /* reset the policy's ready queues */
+   void     (*fork)(proc_ptr);        /* set up policy state of a new process */
+   void     (*enqueue)(proc_ptr);     /* process has become READY */
+   void     (*dequeue)(proc_ptr);     /* process is leaving the ready queues */
+   proc_ptr (*pick_next)(proc_ptr);   /* who runs next; may return Current */
+   int      (*tick)(proc_ptr);        /* clock tick, nonzero to preempt */
+   void     (*yield)(proc_ptr);       /* running process gives up the cpu */
+   int      (*preempt)(proc_ptr, proc_ptr); /* nonzero if a wakeup outranks Current */
+   int      (*first)(proc_ptr);       /* nonzero if a wakeup would run before all READY */
+   void     (*reprio)(proc_ptr);      /* base or inherited priority of a process changed */
+   void     (*handoff)(proc_ptr);     /* a wakeup runs at once without being queued */
+};
+
+/* Scheduling policies compiled into the kernel.  The priority round-robin
+ * policy is always built; others are added with -DCONFIG_SCHED_<NAME>.
+ */
+#define SCHED_DEFAULT "prio"
+
+#ifdef CONFIG_SCHED_STRIDE
+#define SCHED_HAVE_STRIDE 1
+#else
+#define SCHED_HAVE_STRIDE 0
+#endif
+
+#ifdef CONFIG_SCHED_FAIR
+#define SCHED_HAVE_FAIR 1
+#else
+#define SCHED_HAVE_FAIR 0
+#endif
+
+#define SCHED_NPOLICIES (1 + SCHED_HAVE_STRIDE + SCHED_HAVE_FAIR)
+
+/* Stride scheduling constants.  A process with no tickets given at fork
+ * gets STRIDE_TICKETS_PER_LEVEL tickets for every priority level from its
+ * own down to LOWEST_PRIORITY.
+ */
+#define STRIDE1 (1 << 20)
+#define STRIDE_TICKETS_PER_LEVEL 100
+#define STRIDE_MAX_TICKETS 10000
+
+/* Real-time (EDF) class.  Admission keeps the summed budget/period of all
+ * real-time processes at or below EDF_MAX_UTIL per mille of the cpu.
+ */
+#define EDF_MAX_UTIL 1000
+
+/* Optional attributes for fork1_attr(), zero fields take the defaults.
+ *
+ * Priority inheritance is opt-in.  A process forked with inherit set lends
+ * its own priority to whatever it blocks on in join() or zap(), so a lower
+ * priority child or zap target runs ahead of the middle priority work that
+ * would otherwise hold it off.  A waiter without it only passes on what it
+ * inherited itself, so by default join() and zap() keep the plain priority
+ * order and can still see that inversion.  The default stays off because
+ * lending to every child and zap target reorders what the earlier tests
+ * check.
+ */
+typedef struct proc_attr proc_attr;
+
+struct proc_attr {
+   int            tickets;           /* cpu share tickets, 1..STRIDE_MAX_TICKETS */
+   int            period;            /* real-time period in ms, 0 for a normal process */
+   int            budget;            /* cpu ms guaranteed in every period */
+   int            inherit;           /* nonzero: lend our priority in join() and zap() */
+   int            batch;             /* nonzero: cpu-bound batch process */
+};
+
+extern int fork1_attr(char *name, int(*func)(char *), char *arg,
+                      int stacksize, int priority, proc_attr *attr);
+extern void dump_shares(void);
+extern void dump_groups(void);
+extern int group_time(int pid);
+extern int set_group_quota(int pid, int quota_ms, int period_ms);
+extern int deadline_misses(int pid);
+extern char *sched_name(void);
+extern int sched_available(char *name);
+extern int set_wakeup_granularity(int usecs);
+extern int set_preemption(int on);
+extern int set_profiling(int on);
+extern int set_tracing(int on);
+extern void dump_profile(void);
+extern void yield(void);
+extern int set_priority(int pid, int priority);
+
+/* Kernel events for register_hook().  The codes match TRACE_* of trace.h,
+ * so trace_event() subscribes as it is, see set_tracing().
+ */
+#define HOOK_FORK 1              /* pid forked, arg is its parent (0 for none) */
+#define HOOK_SWITCH 2            /* pid runs, arg was running (0 for none) */
+#define HOOK_BLOCK 3             /* pid blocked, arg is its blocked_status */
+#define HOOK_UNBLOCK 4           /* pid made READY, arg is the pid that did it */
+#define HOOK_ZAP 5               /* pid zapped arg */
+#define HOOK_QUIT 6              /* pid quit, arg is its exit code */
+#define HOOK_LAST HOOK_QUIT
+#define HOOK_MAX 8               /* subscribers per event */
+
+typedef void (*hook_func)(int event, int pid, int arg);
+
+extern int register_hook(int event, hook_func func);
+extern int unregister_hook(int event, hook_func func);
+
+/* Output modes of dump_processes_fmt(). */
+#define DUMP_TEXT 0
+#define DUMP_JSON 1
+#define DUMP_CSV 2
+#define DUMP_TREE 3
+#define DUMP_BUF_SIZE 16384     /* room for a full table in any mode */
+
+extern void dump_processes_fmt(int mode);
+
+/* Scheduling classes, for the per-class counters below. */
+#define CLASS_RT 0
+#define CLASS_NORMAL 1
+#define CLASS_BATCH 2
+#define SCHED_NCLASSES 3
+
+/* Load averages are fixed point, LOAD_FIXED_1 is 1.0.  clock_handler()
+ * samples the load every tick; LOAD_EXP_n is LOAD_FIXED_1 / e^(1/ticks)
+ * for averages over 1, 5 and 15 seconds of 20 ms ticks.
+ */
+#define LOAD_FSHIFT 16
+#define LOAD_FIXED_1 (1 << LOAD_FSHIFT)
+#define LOAD_EXP_1 64238         /* 50 ticks */
+#define LOAD_EXP_5 65274         /* 250 ticks */
+#define LOAD_EXP_15 65449        /* 750 ticks */
+
+/* Scheduler event counters, see get_sched_stats(). */
+typedef struct sched_stats sched_stats;
+
+struct sched_stats {
+   int            join_handoffs;     /* quit() switched straight to the joining parent */
+   int            switches_avoided;  /* dispatcher() re-picked Current and returned */
+   int            class_switches[SCHED_NCLASSES]; /* switches away from a process, by its class */
+   int            forks;             /* processes created by fork1() */
+   int            quits;             /* calls to quit() */
+   int            joins;             /* calls to join() by a process with children */
+   int            zaps;              /* calls to zap() */
+   int            switches;          /* context switches */
+   int            preemptions;       /* switches away from a process that could still run */
+   int            ticks;             /* clock interrupts */
+   int            idle_ticks;        /* clock interrupts that found the sentinel running */
+   int            load_avg[3];       /* READY and RUNNING processes over 1, 5 and 15 s */
+};
+
+extern void get_sched_stats(sched_stats *stats);
+extern int stats_map(char *path);
+
+/* Log-bucketed latency histogram, see get_latency().  Bucket b > 0 counts
+ * values of 2^(b-1) .. 2^b - 1 microseconds, bucket 0 counts zeros.  The
+ * exact min and max narrow the first and last buckets.
+ */
+#define LAT_BUCKETS 32
+
+typedef struct lat_hist lat_hist;
+
+struct lat_hist {
+   int            count;             /* values recorded */
+   int            min;               /* smallest value in microseconds */
+   int            max;               /* largest value in microseconds */
+   int            buckets[LAT_BUCKETS];
+};
+
+extern int get_latency(int priority, lat_hist *hist);
+extern int lat_percentile(lat_hist *hist, int pct);
+extern void dump_latency(void);
+extern int get_proc_stats(int pid, proc_stats *stats);
 
@@ -1,32 +1,22 @@
 #include "usloss.h"
-#define DEBUG 0
-extern int debugflag;
+#include "tracepoint.h"
 
 void
 p1_fork(int pid)
 {
-    if(DEBUG && debugflag)
-    {
-        console("p1_fork() called: pid = %d\n", pid);
-    }
+    TP_DEBUG(TP_CAT_HOOK, "p1_fork() called: pid = %d\n", pid);
 } /* p1_fork */
 
 void
 p1_switch(int old, int new)
 {
-    if(DEBUG && debugflag)
-    {
-        console("p1_switch() called: old = %d, new = %d\n", old, new);
-    }
+    TP_DEBUG(TP_CAT_HOOK, "p1_switch() called: old = %d, new = %d\n", old, new);
 } /* p1_switch */
 
 void
 p1_quit(int pid)
 {
-    if(DEBUG && debugflag)
-    {
-        console("p1_quit() called: pid = %d\n", pid);
-    }
+    TP_DEBUG(TP_CAT_HOOK, "p1_quit() called: pid = %d\n", pid);
 } /* p1_quit */
 
 int check_io()
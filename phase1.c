@@ -10,28 +10,131 @@
 #include <strings.h>
 #include <string.h>
 #include <stdio.h>
+#include <stdarg.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
 #include <phase1.h>
 #include "kernel.h"
+#include "trace.h"
+#include "tracepoint.h"
+#include "statspage.h"
 
 /* ------------------------- Prototypes ----------------------------------- */
 int sentinel (char *dummy);
 extern int start1 (char *);
 void dispatcher(void);
+static void switch_to(proc_ptr);
 void launch();
 static void enableInterrupts();
 static void check_deadlock();
 void dump_processes(void);
+static void dump_printf(char *, ...);
+static void dump_json_string(char *);
+static void dump_tree(proc_ptr, int);
+static int subtree_cpu(proc_ptr);
+static char *status_name(int);
 static void insertRL(proc_ptr);
+static void insertRL_front(proc_ptr);
+static void linkRL(proc_ptr, proc_ptr);
+static int rl_rank(proc_ptr);
+static proc_ptr rank_last(int, int);
 int zap(int);
 int is_zapped(void);
 void de_zap(void);
-static void removeFromRL(int);
+static void removeFromRL(proc_ptr);
+static proc_ptr ready_best(void);
 extern void insert_child(proc_ptr);
 int block_me(int);
 int unblock_proc(int);
+static void wake_proc(proc_ptr);
+static void block_proc(proc_ptr, int);
+static int is_throttled(proc_ptr);
 int readtime(void);
+static int proc_cpu(proc_ptr);
+static int slice_remaining(proc_ptr);
+static void charge_slice(proc_ptr);
 void clock_handler(int, void *);
+static void load_tick(void);
+static void run_hooks(int, int, int);
+static void p1_fork_hook(int, int, int);
+static void p1_switch_hook(int, int, int);
+static void p1_quit_hook(int, int, int);
+static void stats_publish(void);
+static void lat_record(lat_hist *, int);
 void mode_checker();
+void sched_init(char *);
+static sched_ops *sched_lookup(char *);
+static void sched_enqueue(proc_ptr);
+static void sched_dequeue(proc_ptr);
+static void sched_handoff(proc_ptr);
+static proc_ptr sched_pick_next(proc_ptr);
+static int sched_tick(proc_ptr);
+static int sched_preempt(proc_ptr, proc_ptr);
+static int sched_first(proc_ptr);
+static int wakeup_preempt(proc_ptr);
+static int proc_class(proc_ptr);
+static int proc_quantum(proc_ptr);
+static void quantum_update(proc_ptr);
+static void sched_yield(proc_ptr);
+static int top_priority(proc_ptr);
+static int lent_priority(proc_ptr);
+static int waiter_priority(proc_ptr);
+static void inherit_update(proc_ptr);
+static void inherit_targets(proc_ptr);
+static int group_usage(proc_ptr);
+static int quota_tick(void);
+static void quota_throttle(proc_ptr);
+static int quota_release(proc_ptr);
+static int edf_admit(proc_attr *);
+static void edf_add(proc_ptr, proc_attr *);
+static void edf_remove(proc_ptr);
+static void edf_wakeup(proc_ptr);
+static void edf_enqueue(proc_ptr);
+static void edf_dequeue(proc_ptr);
+static proc_ptr edf_pick_next(proc_ptr);
+static int edf_tick(proc_ptr);
+static void prio_init(void);
+static void prio_fork(proc_ptr);
+static void prio_enqueue(proc_ptr);
+static void prio_dequeue(proc_ptr);
+static proc_ptr prio_pick_next(proc_ptr);
+static void prio_age(void);
+static int prio_tick(proc_ptr);
+static int short_first(proc_ptr, proc_ptr);
+static int prio_preempt(proc_ptr, proc_ptr);
+static int prio_first(proc_ptr);
+static void prio_yield(proc_ptr);
+static void prio_reprio(proc_ptr);
+static void prio_handoff(proc_ptr);
+#ifdef CONFIG_SCHED_STRIDE
+static void stride_init(void);
+static void stride_fork(proc_ptr);
+static void stride_enqueue(proc_ptr);
+static void stride_dequeue(proc_ptr);
+static proc_ptr stride_pick_next(proc_ptr);
+static int stride_tick(proc_ptr);
+static int stride_preempt(proc_ptr, proc_ptr);
+static int stride_first(proc_ptr);
+static void stride_yield(proc_ptr);
+static void stride_reprio(proc_ptr);
+static void stride_handoff(proc_ptr);
+static void stride_clamp(proc_ptr);
+#endif
+#ifdef CONFIG_SCHED_FAIR
+static void fair_init(void);
+static void fair_fork(proc_ptr);
+static void fair_enqueue(proc_ptr);
+static void fair_dequeue(proc_ptr);
+static proc_ptr fair_pick_next(proc_ptr);
+static int fair_tick(proc_ptr);
+static int fair_preempt(proc_ptr, proc_ptr);
+static int fair_first(proc_ptr);
+static void fair_yield(proc_ptr);
+static void fair_reprio(proc_ptr);
+static void fair_handoff(proc_ptr);
+static void fair_clamp(proc_ptr);
+#endif
 
 /* -------------------------- Globals ------------------------------------- */
 
@@ -42,12 +145,145 @@ int debugflag = 1;
 proc_struct ProcTable[MAXPROC];
 
 /* Process lists  */
-/* ReadyList is a linked list of process pointers */
-proc_ptr ReadyList = NULL;
+/* ReadyList[p] is a linked list of the READY processes at priority p, one
+ * FIFO segment per rank; RankTail[p][r] is the last entry of rank r
+ */
+proc_ptr ReadyList[LOWEST_PRIORITY + 1];
+static proc_ptr RankTail[LOWEST_PRIORITY + 1][RL_RANKS];
+
+/* the same processes in the order they became READY, oldest first */
+static proc_ptr AgeList[LOWEST_PRIORITY + 1];
+static proc_ptr AgeTail[LOWEST_PRIORITY + 1];
+
+/* bit p is set while ReadyList[p] is not empty */
+static unsigned int ready_mask = 0;
+
+/* EdfList holds READY real-time processes, earliest deadline first */
+proc_ptr EdfList = NULL;
+
+/* every live real-time process, for period releases in clock_handler */
+static proc_ptr EdfTasks[MAXPROC];
+static int edf_ntasks = 0;
+
+/* summed budget/period of the admitted real-time processes, per mille */
+static int edf_util = 0;
+
+/* leaders of the groups with a cpu quota, see set_group_quota() */
+static proc_ptr QuotaGroups[MAXPROC];
+static int quota_ngroups = 0;
 
 /* current process ID */
 proc_ptr Current;
 
+/* a wakeup that does not outrank Current only preempts it after this long */
+int wakeup_granularity = WAKEUP_GRANULARITY;
+
+/* scheduler event counters */
+sched_stats SchedStats;
+
+/* READY and RUNNING processes other than the sentinel, for load_tick() */
+static int nr_running = 0;
+
+/* 0 in cooperative mode: the clock never preempts, processes call yield() */
+int preemption = 1;
+
+/* nonzero while clock_handler() samples Current for dump_profile() */
+int profiling = 0;
+
+/* nonzero while trace_event() is subscribed, see set_tracing() */
+static int tracing = 0;
+
+/* ticks sampled so far */
+static int prof_total = 0;
+
+/* process inside yield(), its switch counts as voluntary */
+static proc_ptr yielding = NULL;
+
+/* time from becoming READY to running, by base priority */
+static lat_hist ReadyLatency[LOWEST_PRIORITY + 1];
+
+/* time dispatcher() takes to pick the next process */
+static lat_hist DispatchTime;
+
+/* nonzero if finish() prints dump_latency() */
+int latency_report = 0;
+
+/* subscribers of each kernel event, see register_hook() */
+static hook_func Hooks[HOOK_LAST + 1][HOOK_MAX];
+static int hook_count[HOOK_LAST + 1];
+
+/* calls the subscribers of event, a single test when there are none */
+#define RUN_HOOKS(event, pid, arg) \
+   do { if (hook_count[event] != 0) run_hooks(event, pid, arg); } while (0)
+
+/* live stats page mapped by stats_map(), NULL when off */
+static stats_page *StatsPage = NULL;
+
+/* one process table snapshot, see dump_processes_fmt() */
+static char DumpBuf[DUMP_BUF_SIZE];
+static int dump_len = 0;
+
+/* scheduling policies built into the kernel, the first is the default */
+static sched_ops prio_sched = {"prio", prio_init, prio_fork, prio_enqueue,
+                               prio_dequeue, prio_pick_next, prio_tick,
+                               prio_yield, prio_preempt, prio_first,
+                               prio_reprio, prio_handoff};
+
+#ifdef CONFIG_SCHED_STRIDE
+static sched_ops stride_sched = {"stride", stride_init, stride_fork,
+                                 stride_enqueue, stride_dequeue,
+                                 stride_pick_next, stride_tick, stride_yield,
+                                 stride_preempt, stride_first,
+                                 stride_reprio, stride_handoff};
+
+/* min-heap of READY processes ordered by pass, StrideHeap[1] is the top */
+static proc_ptr StrideHeap[MAXPROC + 1];
+static int stride_heap_size = 0;
+
+/* sentinel only runs when the heap is empty */
+static proc_ptr stride_idle = NULL;
+
+/* pass of the process that was last dispatched */
+static long long global_pass = 0;
+#endif
+
+#ifdef CONFIG_SCHED_FAIR
+static sched_ops fair_sched = {"fair", fair_init, fair_fork, fair_enqueue,
+                               fair_dequeue, fair_pick_next, fair_tick,
+                               fair_yield, fair_preempt, fair_first,
+                               fair_reprio, fair_handoff};
+
+/* READY processes in no particular order, heap_index is the slot + 1 */
+static proc_ptr FairReady[MAXPROC];
+static int fair_nready = 0;
+
+/* sentinel only runs when nothing else is READY */
+static proc_ptr fair_idle = NULL;
+
+/* group_pass of the group that was last dispatched */
+static long long fair_floor = 0;
+#endif
+
+static sched_ops *sched_policies[] = {
+   &prio_sched,
+#ifdef CONFIG_SCHED_STRIDE
+   &stride_sched,
+#endif
+#ifdef CONFIG_SCHED_FAIR
+   &fair_sched,
+#endif
+   NULL
+};
+
+#if SCHED_NPOLICIES > 1
+/* policy chosen at startup; scheduling decisions go through its table */
+static sched_ops *Sched = &prio_sched;
+#define SCHED(op) (Sched->op)
+#else
+/* only one policy is built in, so call it directly */
+#define SCHED(op) (prio_##op)
+#endif
+
 /* the next pid to be assigned */
 unsigned int next_pid = SENTINELPID;
 
@@ -77,27 +313,77 @@ void startup()
       ProcTable[i] = empty_struct;
    }
 
+   /* PHASE1_TP_MASK=mask picks the tracepoint categories that log */
+   if (getenv("PHASE1_TP_MASK") != NULL)
+   {
+      set_tp_mask(strtoul(getenv("PHASE1_TP_MASK"), NULL, 0));
+   }
+
+   /* Default event subscribers: the p1 hooks. */
+   register_hook(HOOK_FORK, p1_fork_hook);
+   register_hook(HOOK_SWITCH, p1_switch_hook);
+   register_hook(HOOK_QUIT, p1_quit_hook);
+
    /* Initialize the Ready list, etc. */
-   if (DEBUG && debugflag)
-      console("startup(): initializing the Ready & Blocked lists\n");
+   TP_INFO(TP_CAT_BOOT, "startup(): initializing the Ready & Blocked lists\n");
+   sched_init(getenv("PHASE1_SCHED"));
+
+   /* PHASE1_TRACE=1 records the scheduling events in the trace ring */
+   if (getenv("PHASE1_TRACE") != NULL &&
+       strcmp(getenv("PHASE1_TRACE"), "1") == 0)
+   {
+      set_tracing(1);
+   }
+
+   /* PHASE1_TRACE_JSON=file streams the scheduling events to file */
+   if (getenv("PHASE1_TRACE_JSON") != NULL &&
+       trace_json(getenv("PHASE1_TRACE_JSON")) < 0)
+   {
+      console("startup(): cannot write %s\n", getenv("PHASE1_TRACE_JSON"));
+   }
+
+   /* PHASE1_PREEMPT=0 starts in cooperative mode */
+   if (getenv("PHASE1_PREEMPT") != NULL &&
+       strcmp(getenv("PHASE1_PREEMPT"), "0") == 0)
+   {
+      set_preemption(0);
+   }
+
+   /* PHASE1_STATS_FILE=file publishes the live stats page in file */
+   if (getenv("PHASE1_STATS_FILE") != NULL &&
+       stats_map(getenv("PHASE1_STATS_FILE")) < 0)
+   {
+      console("startup(): cannot map %s\n", getenv("PHASE1_STATS_FILE"));
+   }
+
+   /* PHASE1_LATENCY=1 prints the latency histograms at finish() */
+   if (getenv("PHASE1_LATENCY") != NULL &&
+       strcmp(getenv("PHASE1_LATENCY"), "1") == 0)
+   {
+      latency_report = 1;
+   }
+
+   /* PHASE1_PROFILE=1 samples every tick and prints a profile at finish() */
+   if (getenv("PHASE1_PROFILE") != NULL &&
+       strcmp(getenv("PHASE1_PROFILE"), "1") == 0)
+   {
+      set_profiling(1);
+   }
 
    /* Initialize the clock interrupt handler */
    int_vec[CLOCK_DEV] = clock_handler;
 
    /* startup a sentinel process */
-   if (DEBUG && debugflag)
-       console("startup(): calling fork1() for sentinel\n");
+   TP_INFO(TP_CAT_BOOT, "startup(): calling fork1() for sentinel\n");
    result = fork1("sentinel", sentinel, NULL, USLOSS_MIN_STACK, 
                   SENTINELPRIORITY);
    if (result < 0) {
-      if (DEBUG && debugflag)
-         console("startup(): fork1 of sentinel returned error, halting...\nResult = %d\n", result);
+      TP_ERR(TP_CAT_BOOT, "startup(): fork1 of sentinel returned error, halting...\nResult = %d\n", result);
       halt(1);
    }
 
    /* start the test process */
-   if (DEBUG && debugflag)
-      console("startup(): calling fork1() for start1\n");
+   TP_INFO(TP_CAT_BOOT, "startup(): calling fork1() for start1\n");
    result = fork1("start1", start1, NULL, 2 * USLOSS_MIN_STACK, 1);
    if (result < 0) {
       console("startup(): fork1 for start1 returned an error, halting...\n");
@@ -120,8 +406,15 @@ void startup()
    ----------------------------------------------------------------------- */
 void finish()
 {
-   if (DEBUG && debugflag)
-      console("All processes completed.\n");
+   TP_INFO(TP_CAT_BOOT, "All processes completed.\n");
+   tp_flush();
+   trace_json(NULL);
+   if (prof_total > 0)
+      dump_profile();
+   if (latency_report)
+      dump_latency();
+   if (StatsPage != NULL)
+      stats_publish();
 } /* finish */
 
 
@@ -138,16 +431,49 @@ void finish()
                   process information changed
    ------------------------------------------------------------------------ */
 int fork1(char *name, int(*f)(char *), char *arg, int stacksize, int priority)
+{
+   return fork1_attr(name, f, arg, stacksize, priority, NULL);
+} /* fork1 */
+
+
+/* ------------------------------------------------------------------------
+   Name - fork1_attr
+   Purpose - Same as fork1, but takes optional scheduling attributes for
+             the new process.
+   Parameters - as fork1, plus a pointer to the attributes or NULL for
+                the defaults.
+   Returns - the process id of the created child, -1 if no child could
+             be created or the priority or attributes are out of range.
+   Side Effects - as fork1
+   ------------------------------------------------------------------------ */
+int fork1_attr(char *name, int(*f)(char *), char *arg, int stacksize,
+               int priority, proc_attr *attr)
 {
    /* set to 0 for searching an empty slot in the process table */
    int proc_slot = 0;
 
-   if (DEBUG && debugflag)
-      console("fork1(): creating process %s\n", name);
+   TP_DEBUG(TP_CAT_PROC, "fork1(): creating process %s\n", name);
 
    /* test if in kernel mode; halt if in user mode */
    mode_checker("fork1()");
 
+   /* Return if the attributes are out of range */
+   if (attr != NULL &&
+       (attr->tickets < 0 || attr->tickets > STRIDE_MAX_TICKETS ||
+        attr->period < 0 || attr->budget < 0 ||
+        (attr->period > 0 && (attr->budget == 0 || attr->budget > attr->period)) ||
+        (attr->period > 0 && attr->batch)))
+   {
+      return (-1);
+   }
+
+   /* Return if a real-time process would overload the cpu */
+   if (attr != NULL && attr->period > 0 && edf_admit(attr) != 0)
+   {
+      console("fork1(): real-time process %s rejected, cpu overloaded.\n", name);
+      return (-1);
+   }
+
    /* Return if stack size is too small */
    if (stacksize < USLOSS_MIN_STACK)
    {
@@ -207,18 +533,65 @@ int fork1(char *name, int(*f)(char *), char *arg, int stacksize, int priority)
    /* process priority */
    ProcTable[proc_slot].priority = priority;
 
+   /* cpu share tickets, scaled from the priority unless given */
+   if (attr != NULL && attr->tickets > 0)
+      ProcTable[proc_slot].tickets = attr->tickets;
+   else
+      ProcTable[proc_slot].tickets =
+         (LOWEST_PRIORITY + 1 - priority) * STRIDE_TICKETS_PER_LEVEL;
+
    /* process status (READY by default) */
    ProcTable[proc_slot].status = READY;
+   if (ProcTable[proc_slot].pid != SENTINELPID)
+      nr_running++;
+
+   /* a full time slice for the first run, sized like the parent's */
+   ProcTable[proc_slot].batch = (attr != NULL && attr->batch);
+   ProcTable[proc_slot].quantum = QUANTUM;
+   ProcTable[proc_slot].slice_ema = QUANTUM / 2;
+   if (Current != NULL && !Current->batch)
+   {
+      ProcTable[proc_slot].quantum = Current->quantum;
+      ProcTable[proc_slot].slice_ema = Current->slice_ema;
+   }
+   ProcTable[proc_slot].prof_ticks = 0;
+   memset(&ProcTable[proc_slot].stats, 0, sizeof(proc_stats));
+   ProcTable[proc_slot].stat_since = sys_clock();
+   ProcTable[proc_slot].woken = 0;
+   ProcTable[proc_slot].slice_left = proc_quantum(&ProcTable[proc_slot]);
+
+   /* priority inheritance, see inherit_update() */
+   ProcTable[proc_slot].inh_priority = NO_INHERIT;
+   ProcTable[proc_slot].zap_target = NULL;
+   ProcTable[proc_slot].lends = (attr != NULL && attr->inherit);
 
    /* if Current is a Parent process, insert the child link & add to num_kids. */
    if (Current != NULL)
    {
       insert_child(&ProcTable[proc_slot]); 
       Current->num_kids ++;                
+      Current->stats.forks++;
    }
 
-   /* Point to process in the ReadyList */
-   insertRL(&ProcTable[proc_slot]);
+   /* each child of start1 leads a group made of its subtree */
+   ProcTable[proc_slot].group_cpu = 0;
+   ProcTable[proc_slot].group_pass = 0;
+   ProcTable[proc_slot].quota = 0;
+   ProcTable[proc_slot].throttled = 0;
+   ProcTable[proc_slot].throttle_events = 0;
+   ProcTable[proc_slot].throttled_time = 0;
+   if (Current == NULL || Current->parent_ptr == NULL)
+      ProcTable[proc_slot].group = &ProcTable[proc_slot];
+   else
+      ProcTable[proc_slot].group = Current->group;
+
+   /* Hand the new process to the scheduler */
+   SCHED(fork)(&ProcTable[proc_slot]);
+   if (attr != NULL && attr->period > 0)
+   {
+      edf_add(&ProcTable[proc_slot], attr);
+   }
+   sched_enqueue(&ProcTable[proc_slot]);
 
    /* Initialize context for this process, but use launch function pointer for
     * the initial value of the process's program counter (PC)
@@ -227,20 +600,24 @@ int fork1(char *name, int(*f)(char *), char *arg, int stacksize, int priority)
                 ProcTable[proc_slot].stack, 
                 ProcTable[proc_slot].stacksize, launch);
 
-   /* call dispatcher - exception for sentinel */
-   if (strcmp(ProcTable[proc_slot].name, "sentinel") != 0)
+   /* for future phase(s), before the child can run and quit */
+   SchedStats.forks++;
+   trace_name(ProcTable[proc_slot].pid, ProcTable[proc_slot].name);
+   RUN_HOOKS(HOOK_FORK, ProcTable[proc_slot].pid,
+             Current != NULL ? Current->pid : 0);
+
+   /* call dispatcher if the child should run now - exception for sentinel */
+   if (strcmp(ProcTable[proc_slot].name, "sentinel") != 0 &&
+       wakeup_preempt(&ProcTable[proc_slot]))
    {
       //console("fork1(): calling dispatcher\n");
       dispatcher();
    }
-   
-   /* for future phase(s) */
-   p1_fork(ProcTable[proc_slot].pid);
 
    /* Return PID of created process */
    return (ProcTable[proc_slot].pid);
 
-} /* fork1 */
+} /* fork1_attr */
 
 
 /* ------------------------------------------------------------------------
@@ -255,8 +632,7 @@ void launch()
 {
    int result;
 
-   if (DEBUG && debugflag)
-      console("launch(): started\n");
+   TP_DEBUG(TP_CAT_PROC, "launch(): started\n");
 
    /* Enable interrupts */
    enableInterrupts();
@@ -264,8 +640,7 @@ void launch()
    /* Call the function passed to fork1, and capture its return value */
    result = Current->start_func(Current->start_arg);
 
-   if (DEBUG && debugflag)
-      console("Process %d returned to launch\n", Current->pid);
+   TP_DEBUG(TP_CAT_PROC, "Process %d returned to launch\n", Current->pid);
 
    quit(result);
 
@@ -291,9 +666,13 @@ int join(int *status)
    {
       return -2;  
    }
+   SchedStats.joins++;
 
    /* Current process has called join so needs to be blocked until child process quits. */
-   Current->status = BLOCKED;
+   block_proc(Current, JOIN_BLOCK);
+
+   /* Children inherit from us until one of them quits. */
+   inherit_targets(Current);
 
    /* Ensuring the status is BLOCKED to call dispatcher. */
    if(Current->status == BLOCKED)
@@ -328,7 +707,9 @@ int join(int *status)
    ------------------------------------------------------------------------ */
 void quit(int code)
 {
-   
+   proc_ptr parent = Current->parent_ptr;
+   proc_ptr handoff = NULL;
+
    /* Testing kernel mode. */
    mode_checker("quit()");
 
@@ -341,16 +722,37 @@ void quit(int code)
    }
 
    /* Setting to QUIT. */
+   if (Current->status == RUNNING)
+      nr_running--;
    Current->status = QUIT;
+   SchedStats.quits++;
+
+   /* Give back the real-time budget. */
+   if (Current->edf_period != 0)
+   {
+      edf_remove(Current);
+   }
 
    /* Cleanning. */
    de_zap();
 
-   /* Unlock parent watting to join. */
-   if(Current->parent_ptr != NULL && Current->parent_ptr->status == BLOCKED)
+   /* Unlock parent watting to join.  If it would be picked next anyway,
+    * switch to it directly instead of going through the ready queues.
+    */
+   if(parent != NULL && parent->status == BLOCKED)
    {
-      Current->parent_ptr->status == READY;
-      insertRL(Current->parent_ptr);
+      wake_proc(parent);
+
+      /* Our siblings no longer inherit from the parent. */
+      inherit_targets(parent);
+      if (parent->blocked_status == JOIN_BLOCK && sched_first(parent))
+      {
+         handoff = parent;
+      }
+      else
+      {
+         sched_enqueue(parent);
+      }
    }
 
    /* Seind quit code to parrent. */
@@ -361,8 +763,19 @@ void quit(int code)
       Current->parent_ptr->num_kids --;
    }
 
-   dispatcher();
-   p1_quit(Current->pid);
+   /* for future phase(s), while we are still Current */
+   RUN_HOOKS(HOOK_QUIT, Current->pid, code);
+
+   if (handoff != NULL)
+   {
+      sched_handoff(handoff);
+      SchedStats.join_handoffs++;
+      switch_to(handoff);
+   }
+   else
+   {
+      dispatcher();
+   }
 } /* quit */
 
 
@@ -371,32 +784,109 @@ void quit(int code)
    Purpose - dispatches ready processes.  The process with the highest
              priority (the first on the ready list) is scheduled to
              run.  The old process is swapped out and the new process
-             swapped in.
+             swapped in.  When the pick is the running process itself
+             the ready queues and the context are left alone.
    Parameters - none
    Returns - nothing
    Side Effects - the context of the machine is changed
    ----------------------------------------------------------------------- */
 void dispatcher(void)
 {
+   proc_ptr next_process;
+   int start = sys_clock();
 
-   /* Check priority under the time limit for current process to continue to run. */  
-   if(Current != NULL && Current->priority <= ReadyList->priority && Current->status == RUNNING && readtime() < 80)
+   /* Ask the scheduling policy who runs next, it may keep Current running. */
+   next_process = sched_pick_next(Current);
+   if (next_process == Current)
    {
+      SchedStats.switches_avoided++;
+      lat_record(&DispatchTime, sys_clock() - start);
+
+      /* Current keeps the cpu; once its quantum is spent it gets a new one. */
+      if (Current != NULL && slice_remaining(Current) <= 0)
+      {
+         charge_slice(Current);
+         quantum_update(Current);
+         Current->slice_left = proc_quantum(Current);
+         Current->run_since = sys_clock();
+      }
       return;
    }
 
-   proc_ptr next_process;
+   sched_dequeue(next_process);
+   lat_record(&DispatchTime, sys_clock() - start);
+   switch_to(next_process);
+} /* dispatcher */
+
+
+/* ------------------------------------------------------------------------
+   Name - switch_to
+   Purpose - Swaps the running process out and next_process in.
+   Parameters - the process to run, already off the ready queues
+   Returns - nothing
+   Side Effects - Current is changed, a still running old process is
+                  put back on the ready queues, the context of the
+                  machine is changed
+   ----------------------------------------------------------------------- */
+static void switch_to(proc_ptr next_process)
+{
    proc_ptr old_process;
+   int now = sys_clock();
+   int waited;
 
-   next_process = ReadyList;
    old_process = Current;
+
+   /* Statistics: old_process starts waiting, next_process stops. */
+   if (old_process != NULL)
+   {
+      SchedStats.switches++;
+      if ((old_process->status != RUNNING &&
+           !is_throttled(old_process)) || old_process == yielding)
+      {
+         old_process->stats.vol_switches++;
+      }
+      else
+      {
+         old_process->stats.invol_switches++;
+         SchedStats.preemptions++;
+      }
+      old_process->stat_since = now;
+   }
+   waited = now - next_process->stat_since;
+   next_process->stats.ready_time += waited;
+   lat_record(&ReadyLatency[next_process->priority],
+              now - next_process->queued_at);
+   if (next_process->woken)
+   {
+      next_process->woken = 0;
+      next_process->stats.wake_latency += waited;
+      if (waited > next_process->stats.max_wake_latency)
+         next_process->stats.max_wake_latency = waited;
+   }
+
+   /* Charge old_process for this run before it is requeued.  A process
+    * that stopped running starts its next run with a full quantum.
+    */
+   if (old_process != NULL)
+   {
+      SchedStats.class_switches[proc_class(old_process)]++;
+      charge_slice(old_process);
+      if (old_process->status != RUNNING)
+      {
+         quantum_update(old_process);
+         old_process->slice_left = proc_quantum(old_process);
+      }
+   }
+
+   RUN_HOOKS(HOOK_SWITCH, next_process->pid,
+             old_process == NULL ? 0 : old_process->pid);
    Current = next_process;
+   next_process->run_since = sys_clock();
 
    /* Checking old_process if is NULL so the next_process can RUN. */
    if (old_process == NULL)
    {
       next_process->status = RUNNING;
-      removeFromRL(next_process->pid);
       next_process->start_time = sys_clock();
       context_switch(NULL, &next_process->state);
    }
@@ -404,9 +894,6 @@ void dispatcher(void)
    else if (old_process->status == QUIT)
    {
       next_process->status = RUNNING;
-      removeFromRL(next_process->pid);
-      /* Get time spent in porcessor for old_process and update pc_time. */
-      old_process->pc_time = old_process->pc_time + readtime();
       next_process->start_time = sys_clock();
       context_switch(&old_process->state, &next_process->state);
    }
@@ -414,22 +901,26 @@ void dispatcher(void)
    else
    {
       next_process->status = RUNNING;
-      removeFromRL(next_process->pid);
 
       /* if the "running" process is not-blocked, insert it into the ready list. */
       if (old_process->status != BLOCKED)
       {
          old_process->status = READY;
-         insertRL(old_process);
+         sched_yield(old_process);
+
+         /* a preempted process keeps the rest of its quantum */
+         if (old_process->slice_left <= 0)
+         {
+            quantum_update(old_process);
+            old_process->slice_left = proc_quantum(old_process);
+         }
       }
 
-      /* Get time spent in porcessor for old_process and update pc_time. */
-      old_process->pc_time = old_process->pc_time + readtime();
-      next_process->start_time = sys_clock(); 
+      next_process->start_time = sys_clock();
       context_switch(&old_process->state, &next_process->state);
    }
    
-} /* dispatcher */
+} /* switch_to */
 
 
 /* ------------------------------------------------------------------------
@@ -445,12 +936,15 @@ void dispatcher(void)
    ----------------------------------------------------------------------- */
 int sentinel (char *dummy)
 {
-   if (DEBUG && debugflag)
-      console("sentinel(): called\n");
+   TP_DEBUG(TP_CAT_SCHED, "sentinel(): called\n");
    while (1)
    {
       check_deadlock();
       waitint();
+
+      /* nothing preempts us in cooperative mode, so give way ourselves */
+      if (!preemption)
+         dispatcher();
    }
 } /* sentinel */
 
@@ -459,6 +953,24 @@ int sentinel (char *dummy)
 static void check_deadlock()
 {
 
+   /* Real-time processes parked until their next period are not stuck. */
+   for (int i = 0; i < edf_ntasks; i++)
+   {
+      if (EdfTasks[i]->edf_throttled)
+      {
+         return;
+      }
+   }
+
+   /* Neither are groups parked until their next quota period. */
+   for (int i = 0; i < quota_ngroups; i++)
+   {
+      if (QuotaGroups[i]->throttled)
+      {
+         return;
+      }
+   }
+
    /* Check PCB if any processes are active. */
    for( int i = 0; i < MAXPROC; i++)
    {
@@ -501,15 +1013,260 @@ static void enableInterrupts()
    ---------------------------------------------------------------------------------*/
 void clock_handler(int dev, void *unit)
 {
-   if (readtime() >= 80)
+   int resched;
+
+   SchedStats.ticks++;
+   if (Current->pid == SENTINELPID)
+   {
+      SchedStats.idle_ticks++;
+   }
+   load_tick();
+   if (StatsPage != NULL)
+   {
+      stats_publish();
+   }
+
+   /* one profiler sample per tick, charged to whoever was interrupted */
+   if (profiling && Current != NULL)
    {
-      console("clock_handler(): calling dispatcher().");
+      Current->prof_ticks++;
+      prof_total++;
+   }
+
+   resched = sched_tick(Current);
+
+   /* quotas are enforced by preemption, so cooperative mode skips them */
+   if (preemption && quota_tick())
+   {
+      resched = 1;
+   }
+
+   /* in cooperative mode the tick only does the accounting */
+   if (resched && preemption)
+   {
+      TP_INFO(TP_CAT_SCHED, "clock_handler(): calling dispatcher().");
       dispatcher();
    }
    return;
 } /* clock_handler */
 
 
+/* One step of the load averages: nr_running decayed into each average
+ * like the Unix load.
+ */
+static void load_tick(void)
+{
+   static const int exps[3] = {LOAD_EXP_1, LOAD_EXP_5, LOAD_EXP_15};
+   long long load;
+   int i;
+
+   for (i = 0; i < 3; i++)
+   {
+      load = (long long)SchedStats.load_avg[i] * exps[i] +
+             (long long)nr_running * LOAD_FIXED_1 * (LOAD_FIXED_1 - exps[i]);
+      SchedStats.load_avg[i] = (load + LOAD_FIXED_1 / 2) >> LOAD_FSHIFT;
+   }
+} /* load_tick */
+
+
+/* --------------------------------------------------------------------------------
+   Name - register_hook
+   Purpose - Subscribes func to a kernel event.  Subscribers run in the
+             order they registered, in kernel mode at the point the event
+             happens, so they must not block.  startup() registers the
+             p1_* hooks for fork, switch and quit; set_tracing() adds
+             trace_event() to every event while the trace is on, which
+             takes one more of the HOOK_MAX slots of each.
+   Parameters - a HOOK_* event and the function to call with the event,
+                the pid and the argument of the event
+   Returns - 0, or -1 for a bad event, a NULL or already registered func
+             or a full list
+   --------------------------------------------------------------------------------*/
+int register_hook(int event, hook_func func)
+{
+   int i;
+
+   if (event < HOOK_FORK || event > HOOK_LAST || func == NULL ||
+       hook_count[event] == HOOK_MAX)
+   {
+      return -1;
+   }
+   for (i = 0; i < hook_count[event]; i++)
+   {
+      if (Hooks[event][i] == func)
+      {
+         return -1;
+      }
+   }
+   Hooks[event][hook_count[event]++] = func;
+   return 0;
+} /* register_hook */
+
+
+/* --------------------------------------------------------------------------------
+   Name - unregister_hook
+   Purpose - Removes a subscriber added by register_hook(), keeping the
+             order of the others.
+   Parameters - the event and the function
+   Returns - 0, or -1 if func was not subscribed to event
+   --------------------------------------------------------------------------------*/
+int unregister_hook(int event, hook_func func)
+{
+   int i;
+
+   if (event < HOOK_FORK || event > HOOK_LAST)
+   {
+      return -1;
+   }
+   for (i = 0; i < hook_count[event]; i++)
+   {
+      if (Hooks[event][i] == func)
+      {
+         break;
+      }
+   }
+   if (i == hook_count[event])
+   {
+      return -1;
+   }
+   for (hook_count[event]--; i < hook_count[event]; i++)
+   {
+      Hooks[event][i] = Hooks[event][i + 1];
+   }
+   return 0;
+} /* unregister_hook */
+
+
+/* Calls every subscriber of event.  The list is copied first, so a
+ * subscriber that registers or unregisters one changes the next event,
+ * not this one.
+ */
+static void run_hooks(int event, int pid, int arg)
+{
+   hook_func funcs[HOOK_MAX];
+   int count = hook_count[event];
+   int i;
+
+   memcpy(funcs, Hooks[event], count * sizeof(hook_func));
+   for (i = 0; i < count; i++)
+   {
+      funcs[i](event, pid, arg);
+   }
+} /* run_hooks */
+
+
+/* The p1_* hooks of later phases as default subscribers. */
+static void p1_fork_hook(int event, int pid, int arg)
+{
+   p1_fork(pid);
+} /* p1_fork_hook */
+
+static void p1_switch_hook(int event, int pid, int arg)
+{
+   p1_switch(arg, pid);
+} /* p1_switch_hook */
+
+static void p1_quit_hook(int event, int pid, int arg)
+{
+   p1_quit(pid);
+} /* p1_quit_hook */
+
+
+/* --------------------------------------------------------------------------------
+   Name - stats_map
+   Purpose - Creates file as a live stats page (see statspage.h) and maps
+             it shared, so other processes can watch the kernel through
+             it.  clock_handler() rewrites the page every tick.
+   Parameters - path of the file
+   Returns - 0, or -1 if a page is already mapped or the file cannot be
+             created and mapped
+   --------------------------------------------------------------------------------*/
+int stats_map(char *path)
+{
+   int fd;
+   void *page;
+   unsigned int psr;
+
+   if (StatsPage != NULL)
+   {
+      return -1;
+   }
+
+   fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+   if (fd < 0)
+   {
+      return -1;
+   }
+   if (ftruncate(fd, sizeof(stats_page)) < 0)
+   {
+      close(fd);
+      return -1;
+   }
+   page = mmap(NULL, sizeof(stats_page), PROT_READ | PROT_WRITE, MAP_SHARED,
+               fd, 0);
+   close(fd);
+   if (page == MAP_FAILED)
+   {
+      return -1;
+   }
+
+   /* the first publish must not race the one in clock_handler() */
+   psr = psr_get();
+   psr_set(psr & ~PSR_CURRENT_INT);
+   StatsPage = page;
+   StatsPage->magic = STATS_MAGIC;
+   StatsPage->version = STATS_VERSION;
+   stats_publish();
+   psr_set(psr);
+   return 0;
+} /* stats_map */
+
+
+/* Rewrites the stats page inside a seqlock write section. */
+static void stats_publish(void)
+{
+   stats_page *page = StatsPage;
+   stats_slot *slot;
+   proc_ptr proc;
+   int i;
+
+   page->seq++;
+   __sync_synchronize();
+
+   page->time = sys_clock();
+   page->forks = SchedStats.forks;
+   page->quits = SchedStats.quits;
+   page->switches = SchedStats.switches;
+   page->preemptions = SchedStats.preemptions;
+   page->ticks = SchedStats.ticks;
+   page->idle_ticks = SchedStats.idle_ticks;
+   for (i = 0; i < 3; i++)
+   {
+      page->load_avg[i] = SchedStats.load_avg[i];
+   }
+
+   for (i = 0; i < MAXPROC && i < STATS_NSLOTS; i++)
+   {
+      proc = &ProcTable[i];
+      slot = &page->slots[i];
+      slot->pid = proc->pid;
+      if (proc->pid == 0)
+      {
+         continue;
+      }
+      slot->parent = proc->parent_ptr != NULL ? proc->parent_ptr->pid : 0;
+      slot->status = proc->status;
+      slot->priority = proc->priority;
+      slot->cpu_time = proc_cpu(proc);
+      strncpy(slot->name, proc->name, STATS_NAMELEN - 1);
+      slot->name[STATS_NAMELEN - 1] = '\0';
+   }
+
+   __sync_synchronize();
+   page->seq++;
+} /* stats_publish */
+
+
 /* ---------------------------------------------------------------------------------
    Name - zap
    Purpose - a process arranges for another process to be killed by calling zap.
@@ -541,7 +1298,9 @@ int zap(int pid)
    }
 
    /* Process in is_zapped is set to ZAPPED. */
+   SchedStats.zaps++;
    ProcTable[proc_slot].is_zapped = ZAPPED;
+   ProcTable[proc_slot].stats.zapped++;
 
    /* Creating linked list of the zapper. */
    if(ProcTable[proc_slot].zapped_by_ptr == NULL)
@@ -559,14 +1318,20 @@ int zap(int pid)
    }
 
    /* Blocking the process that call zap. */
-   Current->status = BLOCKED;
+   RUN_HOOKS(HOOK_ZAP, Current->pid, pid);
+   block_proc(Current, ZAP_BLOCK);
 
    /* Zapped process called quit. */
    if(ProcTable[proc_slot].status == QUIT){return 0;}
 
+   /* Target runs at least at what we lend until it quits. */
+   Current->zap_target = &ProcTable[proc_slot];
+   inherit_update(Current->zap_target);
+
    /* Calling dispatcher(); */
    //console("zap(): calling dispatcher\n");
    dispatcher();
+   Current->zap_target = NULL;
 
    /* If the zapped process happen while in zap function. */
    if(Current->is_zapped == ZAPPED)
@@ -629,15 +1394,15 @@ void de_zap(void)
          /* Cleanning the process. */
          previous->next_zapper_ptr = NULL;
          /* Setting ready from cleanning. */
-         previous->status = READY;
+         wake_proc(previous);
          /* Additing to the RL. */
-         insertRL(previous);
+         sched_enqueue(previous);
       }
    }
 
    /* Final cleaning. */
-   walker->status = READY;
-   insertRL(walker);
+   wake_proc(walker);
+   sched_enqueue(walker);
 
    return;
 } /* de_zap */
@@ -649,125 +1414,1915 @@ void de_zap(void)
    ------------------------------------------------------------------------------*/
 void dump_processes(void)
 {
+   dump_processes_fmt(DUMP_TEXT);
+} /* dump_processes */
+
 
-   console("\n-----------------------------------------dump_processes-----------------------------------------\n");
-   console("%-8s ", "Entry: ");
-   console("%-8s", "Name:  ");
-   console("%-8s", " PID: ");
-   console("%-16s", " Parent PID: ");
-  
-       
-   console("%-16s", "  # of Children: ");
-   console("%-17s", " CPU time (ms): "); 
-   console("%-16s\n", "Status: ");
+/* ------------------------------------------------------------------------------
+   Name - dump_processes_fmt
+   Purpose - Prints a snapshot of the process table, skipping empty slots.
+             The whole snapshot is formatted into DumpBuf and written with
+             one console() call, so dumping barely disturbs the timing of
+             the processes.
+   Parameters - DUMP_TEXT for the table of dump_processes(), DUMP_JSON or
+                DUMP_CSV for tools, DUMP_TREE for the process tree with
+                the cpu used by each subtree
+   Returns - nothing
+   ------------------------------------------------------------------------------*/
+void dump_processes_fmt(int mode)
+{
+   proc_ptr proc;
+   int first = 1;
+   int i;
 
-   for(int i = 0; i < MAXPROC; i++)
+   dump_len = 0;
+   switch (mode)
    {
-      console("%-8d ", i);
-      console("%-8s ", ProcTable[i].name);
-      console("%-8d ", ProcTable[i].pid);
+   case DUMP_JSON:
+      dump_printf("{\"processes\": [");
+      break;
+   case DUMP_CSV:
+      dump_printf("slot,name,pid,parent,children,priority,cpu_ms,quantum_ms,status\n");
+      break;
+   case DUMP_TREE:
+      dump_printf("\n%-24s%-8s%-16s%-20s%-16s\n", "Name:", "PID:", "CPU time (ms):",
+                  "Subtree CPU (ms):", "Status:");
+      break;
+   default:
+      dump_printf("\n-----------------------------------------dump_processes-----------------------------------------\n");
+      dump_printf("%-9s%-8s%-9s%-16s%-16s%-17s%-16s%-16s\n", "Entry: ", "Name:  ",
+                  " PID: ", " Parent PID: ", "  # of Children: ",
+                  " CPU time (ms): ", " Quantum (ms): ", "Status: ");
+      break;
+   }
 
-      if(ProcTable[i].parent_ptr == NULL)
+   for (i = 0; i < MAXPROC; i++)
+   {
+      proc = &ProcTable[i];
+      if (proc->pid == 0)
       {
-         console("%-16s","N/A");
+         continue;
       }
-      else
+
+      switch (mode)
       {
-         console("%-16d", ProcTable[i].parent_ptr->pid);
+      case DUMP_JSON:
+         dump_printf("%s\n  {\"slot\": %d, \"name\": \"", first ? "" : ",", i);
+         dump_json_string(proc->name);
+         dump_printf("\", \"pid\": %d, \"parent\": %d, \"children\": %d, "
+                     "\"priority\": %d, \"cpu_ms\": %d, \"quantum_ms\": %d, "
+                     "\"status\": \"%s\"}",
+                     proc->pid, proc->parent_ptr ? proc->parent_ptr->pid : 0,
+                     proc->num_kids, proc->priority, proc_cpu(proc) / 1000,
+                     proc_quantum(proc) / 1000, status_name(proc->status));
+         break;
+      case DUMP_CSV:
+         dump_printf("%d,%s,%d,%d,%d,%d,%d,%d,%s\n", i, proc->name, proc->pid,
+                     proc->parent_ptr ? proc->parent_ptr->pid : 0,
+                     proc->num_kids, proc->priority, proc_cpu(proc) / 1000,
+                     proc_quantum(proc) / 1000, status_name(proc->status));
+         break;
+      case DUMP_TREE:
+         if (proc->parent_ptr == NULL)
+         {
+            dump_tree(proc, 0);
+         }
+         break;
+      default:
+         dump_printf("%-8d %-8s %-8d ", i, proc->name, proc->pid);
+         if (proc->parent_ptr == NULL)
+            dump_printf("%-16s", "N/A");
+         else
+            dump_printf("%-16d", proc->parent_ptr->pid);
+         dump_printf("%-16d%-17d%-16d%-16s\n", proc->num_kids,
+                     proc_cpu(proc) / 1000, proc_quantum(proc) / 1000,
+                     status_name(proc->status));
+         break;
+      }
+      first = 0;
+   }
+
+   if (mode == DUMP_JSON)
+   {
+      dump_printf("\n]}\n");
+   }
+   console("%s", DumpBuf);
+} /* dump_processes_fmt */
+
+
+/* Appends to DumpBuf, dropping whatever does not fit. */
+static void dump_printf(char *fmt, ...)
+{
+   va_list args;
+   int n;
+
+   va_start(args, fmt);
+   n = vsnprintf(DumpBuf + dump_len, sizeof(DumpBuf) - dump_len, fmt, args);
+   va_end(args);
+   if (n > 0)
+   {
+      dump_len += n;
+   }
+   if (dump_len >= (int)sizeof(DumpBuf))
+   {
+      dump_len = sizeof(DumpBuf) - 1;
+   }
+} /* dump_printf */
+
+
+/* Appends str to DumpBuf with JSON string escapes. */
+static void dump_json_string(char *str)
+{
+   for (; *str != '\0'; str++)
+   {
+      if (*str == '"' || *str == '\\')
+         dump_printf("\\%c", *str);
+      else if ((unsigned char)*str < ' ')
+         dump_printf("\\u%04x", *str);
+      else
+         dump_printf("%c", *str);
+   }
+} /* dump_json_string */
+
+
+/* Appends proc and its descendants to DumpBuf, one line each, indented
+ * by depth, with the cpu used by the whole subtree.
+ */
+static void dump_tree(proc_ptr proc, int depth)
+{
+   proc_ptr child;
+
+   dump_printf("%*s%-*s%-8d%-16d%-20d%-16s\n", 2 * depth, "",
+               depth < 12 ? 24 - 2 * depth : 0, proc->name, proc->pid,
+               proc_cpu(proc) / 1000, subtree_cpu(proc) / 1000,
+               status_name(proc->status));
+   for (child = proc->child_proc_ptr; child != NULL; child = child->next_sibling_ptr)
+   {
+      dump_tree(child, depth + 1);
+   }
+} /* dump_tree */
+
+
+/* Cpu microseconds used by proc and all of its descendants. */
+static int subtree_cpu(proc_ptr proc)
+{
+   proc_ptr child;
+   int cpu = proc_cpu(proc);
+
+   for (child = proc->child_proc_ptr; child != NULL; child = child->next_sibling_ptr)
+   {
+      cpu += subtree_cpu(child);
+   }
+   return cpu;
+} /* subtree_cpu */
+
+
+/* Name of a process status for the dumps. */
+static char *status_name(int status)
+{
+   switch (status)
+   {
+   case READY:
+      return "READY";
+   case BLOCKED:
+      return "BLOCKED";
+   case RUNNING:
+      return "RUNNING";
+   case QUIT:
+      return "QUIT";
+   default:
+      return "-1";
+   }
+} /* status_name */
+
+
+/* -------------------------------------------------------------------------------
+   Name - insertRL
+   Purpose - appends an entry to its rank's segment of the ReadyList of its
+             effective priority and stamps the time it became READY
+   Parameters - a process pointer to a PCB block
+   -------------------------------------------------------------------------------*/
+static void insertRL(proc_ptr proc)
+{
+   int prio = proc->eff_priority;
+
+   proc->rl_rank = rl_rank(proc);
+   linkRL(proc, rank_last(prio, proc->rl_rank));
+   RankTail[prio][proc->rl_rank] = proc;
+} /* insertRL */
+
+
+/* -------------------------------------------------------------------------------
+   Name - insertRL_front
+   Purpose - inserts an entry ahead of the others of its rank on the
+             ReadyList of its effective priority and stamps the time it
+             became READY
+   Parameters - a process pointer to a PCB block
+   -------------------------------------------------------------------------------*/
+static void insertRL_front(proc_ptr proc)
+{
+   int prio = proc->eff_priority;
+
+   proc->rl_rank = rl_rank(proc);
+   linkRL(proc, proc->rl_rank == 0 ? NULL : rank_last(prio, proc->rl_rank - 1));
+   if (RankTail[prio][proc->rl_rank] == NULL)
+   {
+      RankTail[prio][proc->rl_rank] = proc;
+   }
+} /* insertRL_front */
+
+
+/* Links proc into its ReadyList after prev, or at the head if prev is NULL. */
+static void linkRL(proc_ptr proc, proc_ptr prev)
+{
+   int prio = proc->eff_priority;
+
+   proc->ready_since = sys_clock();
+   proc->prev_proc_ptr = prev;
+   if (prev == NULL)
+   {
+      proc->next_proc_ptr = ReadyList[prio];
+      ReadyList[prio] = proc;
+   }
+   else
+   {
+      proc->next_proc_ptr = prev->next_proc_ptr;
+      prev->next_proc_ptr = proc;
+   }
+   if (proc->next_proc_ptr != NULL)
+   {
+      proc->next_proc_ptr->prev_proc_ptr = proc;
+   }
+   ready_mask |= 1 << prio;
+
+   /* it is the newest arrival whatever its place in the run order */
+   proc->next_age_ptr = NULL;
+   proc->prev_age_ptr = AgeTail[prio];
+   if (AgeTail[prio] == NULL)
+      AgeList[prio] = proc;
+   else
+      AgeTail[prio]->next_age_ptr = proc;
+   AgeTail[prio] = proc;
+} /* linkRL */
+
+
+/* Last entry of ReadyList[prio] of rank or better, NULL if there is none. */
+static proc_ptr rank_last(int prio, int rank)
+{
+   for (; rank >= 0; rank--)
+   {
+      if (RankTail[prio][rank] != NULL)
+      {
+         return RankTail[prio][rank];
+      }
+   }
+   return NULL;
+} /* rank_last */
+
+
+/* Where proc goes inside its priority: a process that blocks early, so its
+ * quantum shrank below QUANTUM, before the others, and batch work last.
+ * Peers of one rank stay FIFO however their quanta differ.
+ */
+static int rl_rank(proc_ptr proc)
+{
+   if (proc->batch)
+   {
+      return RANK_BATCH;
+   }
+   return proc->quantum < QUANTUM ? RANK_SHORT : RANK_NORMAL;
+} /* rl_rank */
+
+
+/* --------------------------------------------------------------------------------
+   Name - removeFromRL
+   Purpose - removes entry from the ReadyList of its effective priority in
+             constant time, does nothing if it is not on the list
+   Parameters - a process pointer to a PCB block
+   --------------------------------------------------------------------------------*/
+static void removeFromRL(proc_ptr proc)
+{
+   int prio = proc->eff_priority;
+   int rank = proc->rl_rank;
+
+   if (proc->prev_proc_ptr == NULL && ReadyList[prio] != proc)
+   {
+      return;
+   }
+
+   if (RankTail[prio][rank] == proc)
+   {
+      RankTail[prio][rank] =
+         proc->prev_proc_ptr != NULL && proc->prev_proc_ptr->rl_rank == rank ?
+         proc->prev_proc_ptr : NULL;
+   }
+   if (proc->prev_proc_ptr == NULL)
+      ReadyList[prio] = proc->next_proc_ptr;
+   else
+      proc->prev_proc_ptr->next_proc_ptr = proc->next_proc_ptr;
+   if (proc->next_proc_ptr != NULL)
+      proc->next_proc_ptr->prev_proc_ptr = proc->prev_proc_ptr;
+   if (ReadyList[prio] == NULL)
+      ready_mask &= ~(1 << prio);
+   proc->next_proc_ptr = NULL;
+   proc->prev_proc_ptr = NULL;
+
+   if (proc->prev_age_ptr == NULL)
+      AgeList[prio] = proc->next_age_ptr;
+   else
+      proc->prev_age_ptr->next_age_ptr = proc->next_age_ptr;
+   if (proc->next_age_ptr == NULL)
+      AgeTail[prio] = proc->prev_age_ptr;
+   else
+      proc->next_age_ptr->prev_age_ptr = proc->prev_age_ptr;
+   proc->next_age_ptr = NULL;
+   proc->prev_age_ptr = NULL;
+} /* removeFromRL */
+
+
+/* Head of the highest priority non-empty ReadyList, NULL if all are empty. */
+static proc_ptr ready_best(void)
+{
+   if (ready_mask == 0)
+   {
+      return NULL;
+   }
+   return ReadyList[ffs(ready_mask) - 1];
+} /* ready_best */
+
+
+/* --------------------------------------------------------------------------------
+   Name - sched_init
+   Purpose - Selects the scheduling policy by name and initializes its
+             ready queues.
+   Parameters - name of the policy, NULL for the default policy
+   Returns - nothing
+   Side Effects - halts if the policy is not built into the kernel
+   --------------------------------------------------------------------------------*/
+void sched_init(char *name)
+{
+   sched_ops *ops;
+
+   if (name == NULL)
+   {
+      name = SCHED_DEFAULT;
+   }
+
+   ops = sched_lookup(name);
+   if (ops == NULL)
+   {
+      console("sched_init(): scheduling policy %s is not built in. Halting...\n", name);
+      halt(1);
+   }
+
+#if SCHED_NPOLICIES > 1
+   Sched = ops;
+#endif
+   SCHED(init)();
+} /* sched_init */
+
+
+/* The built-in policy called name, or NULL if there is none. */
+static sched_ops *sched_lookup(char *name)
+{
+   int i;
+
+   for (i = 0; sched_policies[i] != NULL; i++)
+   {
+      if (strcmp(sched_policies[i]->name, name) == 0)
+      {
+         return sched_policies[i];
+      }
+   }
+   return NULL;
+} /* sched_lookup */
+
+
+/* --------------------------------------------------------------------------------
+   Name - sched_name
+   Purpose - Names the scheduling policy picked at startup.
+   Parameters - none
+   Returns - the policy name, as given to PHASE1_SCHED
+   --------------------------------------------------------------------------------*/
+char *sched_name(void)
+{
+#if SCHED_NPOLICIES > 1
+   return Sched->name;
+#else
+   return prio_sched.name;
+#endif
+} /* sched_name */
+
+
+/* --------------------------------------------------------------------------------
+   Name - sched_available
+   Purpose - Tells whether a scheduling policy is built into the kernel.
+   Parameters - name of the policy
+   Returns - 1 if PHASE1_SCHED=name would be accepted, 0 otherwise
+   --------------------------------------------------------------------------------*/
+int sched_available(char *name)
+{
+   return name != NULL && sched_lookup(name) != NULL;
+} /* sched_available */
+
+
+/* --------------------------------------------------------------------------------
+   Scheduling classes.  Real-time processes are handled by the EDF class,
+   which always runs ahead of the policy picked at startup; every other
+   process goes straight to that policy.
+   --------------------------------------------------------------------------------*/
+static void sched_enqueue(proc_ptr proc)
+{
+   proc->queued_at = sys_clock();
+   if (proc->edf_period != 0)
+   {
+      edf_wakeup(proc);
+   }
+   else if (proc->group->throttled)
+   {
+      /* parked until quota_release() */
+      proc->status = BLOCKED;
+      proc->blocked_status = THROTTLE_BLOCK;
+      proc->stats.throttles++;
+      nr_running--;
+   }
+   else
+   {
+      SCHED(enqueue)(proc);
+   }
+} /* sched_enqueue */
+
+
+/* proc, just made READY, runs next without going through the queues.
+ * Only a wakeup that sched_first() approved is handed off, so a real-time
+ * process has budget left and nothing to release.
+ */
+static void sched_handoff(proc_ptr proc)
+{
+   proc->queued_at = sys_clock();
+   if (proc->edf_period == 0)
+   {
+      SCHED(handoff)(proc);
+   }
+} /* sched_handoff */
+
+
+static void sched_dequeue(proc_ptr proc)
+{
+   if (proc->edf_period != 0)
+      edf_dequeue(proc);
+   else
+      SCHED(dequeue)(proc);
+} /* sched_dequeue */
+
+
+static proc_ptr sched_pick_next(proc_ptr cur)
+{
+   if (EdfList != NULL || (cur != NULL && cur->edf_period != 0))
+   {
+      return edf_pick_next(cur);
+   }
+   return SCHED(pick_next)(cur);
+} /* sched_pick_next */
+
+
+static int sched_tick(proc_ptr cur)
+{
+   int preempt = 0;
+
+   if (edf_ntasks > 0)
+   {
+      preempt = edf_tick(cur);
+      if (cur->edf_period != 0)
+      {
+         return preempt;
+      }
+   }
+   return SCHED(tick)(cur) || preempt;
+} /* sched_tick */
+
+
+static void sched_yield(proc_ptr proc)
+{
+   proc->queued_at = sys_clock();
+   if (proc->edf_period != 0)
+      edf_enqueue(proc);
+   else
+      SCHED(yield)(proc);
+} /* sched_yield */
+
+
+/* Nonzero if woken outranks cur; a real-time process outranks any other. */
+static int sched_preempt(proc_ptr woken, proc_ptr cur)
+{
+   if (woken->edf_period != 0 || cur->edf_period != 0)
+   {
+      return woken->edf_period != 0 &&
+             (cur->edf_period == 0 || woken->edf_deadline < cur->edf_deadline);
+   }
+   return SCHED(preempt)(woken, cur);
+} /* sched_preempt */
+
+
+/* Nonzero if proc, just made READY, would run ahead of every queued process. */
+static int sched_first(proc_ptr proc)
+{
+   if (proc->edf_period == 0 && proc->group->throttled)
+   {
+      return 0;
+   }
+   if (proc->edf_period != 0)
+   {
+      return proc->edf_left > 0 && sys_clock() < proc->edf_deadline &&
+             (EdfList == NULL || proc->edf_deadline < EdfList->edf_deadline);
+   }
+   return EdfList == NULL && SCHED(first)(proc);
+} /* sched_first */
+
+
+/* --------------------------------------------------------------------------------
+   Name - wakeup_preempt
+   Purpose - Decides whether a process that just became READY should take
+             the cpu now, so callers can skip a pointless dispatcher pass.
+   Parameters - the process that was made READY and enqueued
+   Returns - nonzero if it outranks Current, or if Current does not
+             outrank it either and has held the cpu for wakeup_granularity
+             microseconds outside cooperative mode; 0 otherwise, and always
+             0 when both are batch processes.
+   Side Effects - in the second case Current gives up the rest of its
+                  quantum, as in yield(), so the pick lets the tie go.
+   --------------------------------------------------------------------------------*/
+static int wakeup_preempt(proc_ptr proc)
+{
+   if (Current == NULL || Current->status != RUNNING)
+   {
+      return 1;
+   }
+
+   /* batch work never preempts batch work on a wakeup */
+   if (proc->batch && Current->batch)
+   {
+      return 0;
+   }
+   if (sched_preempt(proc, Current))
+   {
+      return 1;
+   }
+   if (!preemption || sched_preempt(Current, proc) ||
+       sys_clock() - Current->run_since < wakeup_granularity)
+   {
+      return 0;
+   }
+   charge_slice(Current);
+   Current->slice_left = 0;
+   return 1;
+} /* wakeup_preempt */
+
+
+/* Scheduling class of proc, CLASS_RT, CLASS_NORMAL or CLASS_BATCH. */
+static int proc_class(proc_ptr proc)
+{
+   if (proc->edf_period != 0)
+      return CLASS_RT;
+   return proc->batch ? CLASS_BATCH : CLASS_NORMAL;
+} /* proc_class */
+
+
+/* Length of a full time slice for proc. */
+static int proc_quantum(proc_ptr proc)
+{
+   return proc->batch ? BATCH_QUANTUM : proc->quantum;
+} /* proc_quantum */
+
+
+/* --------------------------------------------------------------------------------
+   Name - quantum_update
+   Purpose - Called when a slice of proc ends, because it was used up or
+             because proc blocked or quit.  The cpu used in the slice goes
+             into an exponential moving average, and the next quantum is
+             twice that average within MIN_QUANTUM..MAX_QUANTUM.  A process
+             that keeps using up its slice grows its quantum by about an
+             eighth each time; one that blocks early ends up with a short
+             quantum, which also puts it ahead of longer-quantum processes
+             of its priority whenever it becomes READY (see short_first()).
+   Parameters - a process pointer to a PCB block, already charged
+   --------------------------------------------------------------------------------*/
+static void quantum_update(proc_ptr proc)
+{
+   int used = proc->quantum - proc->slice_left;
+
+   if (proc->batch)
+   {
+      return;
+   }
+
+   if (used > proc->quantum)
+      used = proc->quantum;
+   proc->slice_ema += (used - proc->slice_ema) / QUANTUM_EMA_WEIGHT;
+
+   proc->quantum = 2 * proc->slice_ema;
+   if (proc->quantum < MIN_QUANTUM)
+      proc->quantum = MIN_QUANTUM;
+   if (proc->quantum > MAX_QUANTUM)
+      proc->quantum = MAX_QUANTUM;
+} /* quantum_update */
+
+
+/* --------------------------------------------------------------------------------
+   Name - set_preemption
+   Purpose - Switches between preemptive and cooperative mode.  In
+             cooperative mode clock_handler() keeps the accounting but
+             never calls dispatcher(), and a wakeup only takes the cpu
+             when it outranks Current, so the running process keeps it
+             until it blocks, quits or calls yield().
+   Parameters - 0 for cooperative, nonzero for preemptive (the default)
+   Returns - the previous setting
+   --------------------------------------------------------------------------------*/
+int set_preemption(int on)
+{
+   int old = preemption;
+
+   preemption = (on != 0);
+   return old;
+} /* set_preemption */
+
+
+/* --------------------------------------------------------------------------------
+   Name - set_profiling
+   Purpose - Turns the clock-tick profiler on or off.  While it is on,
+             clock_handler() charges each tick to Current; the samples are
+             kept when it is turned off and printed by dump_profile().
+   Parameters - nonzero to sample, 0 to stop (the default)
+   Returns - the previous setting
+   --------------------------------------------------------------------------------*/
+int set_profiling(int on)
+{
+   int old = profiling;
+
+   profiling = (on != 0);
+   return old;
+} /* set_profiling */
+
+
+/* --------------------------------------------------------------------------------
+   Name - set_tracing
+   Purpose - Subscribes trace_event() to every kernel event, or removes it.
+             Events are only recorded in the trace ring, and streamed by
+             trace_json(), while it is on.
+   Parameters - nonzero to record, 0 to stop (the default)
+   Returns - the previous setting
+   --------------------------------------------------------------------------------*/
+int set_tracing(int on)
+{
+   int old = tracing;
+   int event;
+
+   tracing = (on != 0);
+   if (tracing != old)
+   {
+      for (event = HOOK_FORK; event <= HOOK_LAST; event++)
+      {
+         if (tracing)
+            register_hook(event, trace_event);
+         else
+            unregister_hook(event, trace_event);
+      }
+   }
+   return old;
+} /* set_tracing */
+
+
+/* --------------------------------------------------------------------------------
+   Name - yield
+   Purpose - Gives up the rest of the quantum.  Current goes to the tail of
+             its priority, or keeps the cpu without a context switch when
+             nothing else of its priority or better is READY.
+   Parameters - none
+   Returns - nothing
+   --------------------------------------------------------------------------------*/
+void yield(void)
+{
+   mode_checker("yield()");
+
+   charge_slice(Current);
+   Current->slice_left = 0;
+   yielding = Current;
+   dispatcher();
+   yielding = NULL;
+} /* yield */
+
+
+/* --------------------------------------------------------------------------------
+   Name - set_wakeup_granularity
+   Purpose - Sets how long Current runs before any wakeup may preempt it.
+   Parameters - microseconds, 0 lets every wakeup go through the dispatcher
+   Returns - the previous value, or -1 if usecs is negative
+   --------------------------------------------------------------------------------*/
+int set_wakeup_granularity(int usecs)
+{
+   int old = wakeup_granularity;
+
+   if (usecs < 0)
+   {
+      return -1;
+   }
+   wakeup_granularity = usecs;
+   return old;
+} /* set_wakeup_granularity */
+
+
+/* --------------------------------------------------------------------------------
+   Earliest-deadline-first real-time class.  A real-time process gets
+   edf_budget microseconds of cpu in every edf_period; the READY one with
+   the nearest deadline runs first.  clock_handler() charges the budget and
+   parks a process that has used it up until its next period starts.  A
+   period that ends while the process still wanted its budget counts as a
+   deadline miss.
+   --------------------------------------------------------------------------------*/
+static int edf_share(int budget, int period)
+{
+   /* round up so rounding can never admit an overloaded set */
+   return (budget * 1000 + period - 1) / period;
+} /* edf_share */
+
+
+/* Returns 0 if a process with these attributes fits next to the others. */
+static int edf_admit(proc_attr *attr)
+{
+   if (edf_util + edf_share(attr->budget, attr->period) > EDF_MAX_UTIL)
+   {
+      return -1;
+   }
+   return 0;
+} /* edf_admit */
+
+
+static void edf_add(proc_ptr proc, proc_attr *attr)
+{
+   proc->edf_period = attr->period * 1000;
+   proc->edf_budget = attr->budget * 1000;
+   proc->edf_left = proc->edf_budget;
+   proc->edf_deadline = sys_clock() + proc->edf_period;
+   proc->edf_throttled = 0;
+   proc->deadline_misses = 0;
+
+   edf_util += edf_share(attr->budget, attr->period);
+   EdfTasks[edf_ntasks++] = proc;
+} /* edf_add */
+
+
+static void edf_remove(proc_ptr proc)
+{
+   int i;
+
+   for (i = 0; i < edf_ntasks; i++)
+   {
+      if (EdfTasks[i] == proc)
+      {
+         EdfTasks[i] = EdfTasks[--edf_ntasks];
+         break;
+      }
+   }
+   edf_util -= edf_share(proc->edf_budget / 1000, proc->edf_period / 1000);
+} /* edf_remove */
+
+
+/* Take the cpu used since the last charge off the process's budget. */
+static void edf_charge(proc_ptr proc)
+{
+   int cpu = proc_cpu(proc);
+
+   proc->edf_left -= cpu - proc->edf_cpu;
+   proc->edf_cpu = cpu;
+} /* edf_charge */
+
+
+/* Start the next period that contains now, with a full budget. */
+static void edf_release(proc_ptr proc, int now)
+{
+   while (proc->edf_deadline <= now)
+   {
+      proc->edf_deadline += proc->edf_period;
+   }
+   proc->edf_left = proc->edf_budget;
+} /* edf_release */
+
+
+/* A process that slept through its deadline starts afresh, not as a miss. */
+static void edf_wakeup(proc_ptr proc)
+{
+   int now = sys_clock();
+
+   if (now >= proc->edf_deadline)
+   {
+      edf_release(proc, now);
+   }
+   edf_enqueue(proc);
+} /* edf_wakeup */
+
+
+/* Insert by deadline, or park the process if its budget is used up. */
+static void edf_enqueue(proc_ptr proc)
+{
+   proc_ptr walker, previous;
+
+   if (proc->edf_left <= 0)
+   {
+      proc->edf_throttled = 1;
+      return;
+   }
+
+   previous = NULL;
+   walker = EdfList;
+   while (walker != NULL && walker->edf_deadline <= proc->edf_deadline)
+   {
+      previous = walker;
+      walker = walker->next_proc_ptr;
+   }
+   if (previous == NULL)
+   {
+      proc->next_proc_ptr = EdfList;
+      EdfList = proc;
+   }
+   else
+   {
+      previous->next_proc_ptr = proc;
+      proc->next_proc_ptr = walker;
+   }
+} /* edf_enqueue */
+
+
+static void edf_dequeue(proc_ptr proc)
+{
+   proc_ptr walker, previous;
+
+   previous = NULL;
+   walker = EdfList;
+   while (walker != NULL && walker != proc)
+   {
+      previous = walker;
+      walker = walker->next_proc_ptr;
+   }
+   if (walker == NULL)
+   {
+      return;
+   }
+   if (previous == NULL)
+      EdfList = walker->next_proc_ptr;
+   else
+      previous->next_proc_ptr = walker->next_proc_ptr;
+   walker->next_proc_ptr = NULL;
+} /* edf_dequeue */
+
+
+/* Real-time processes outrank everyone; fall back to the policy when none is READY. */
+static proc_ptr edf_pick_next(proc_ptr cur)
+{
+   if (cur != NULL && cur->edf_period != 0 && cur->status == RUNNING)
+   {
+      edf_charge(cur);
+      if (cur->edf_left > 0 &&
+          (EdfList == NULL || cur->edf_deadline <= EdfList->edf_deadline))
+      {
+         return cur;
+      }
+   }
+
+   if (EdfList != NULL)
+   {
+      return EdfList;
+   }
+
+   /* the running real-time process is done, let the policy choose */
+   if (cur != NULL && cur->edf_period != 0)
+   {
+      cur = NULL;
+   }
+   return SCHED(pick_next)(cur);
+} /* edf_pick_next */
+
+
+/* Starts new periods, charges the running budget and says whether to preempt. */
+static int edf_tick(proc_ptr cur)
+{
+   int i;
+   int now;
+   proc_ptr proc;
+
+   if (cur->edf_period != 0)
+   {
+      edf_charge(cur);
+   }
+
+   now = sys_clock();
+   for (i = 0; i < edf_ntasks; i++)
+   {
+      proc = EdfTasks[i];
+      if (now < proc->edf_deadline)
+      {
+         continue;
+      }
+
+      /* still wanted cpu when the period ran out */
+      if (proc->edf_left > 0 &&
+          (proc->status == READY || proc->status == RUNNING))
+      {
+         proc->deadline_misses++;
+      }
+
+      edf_release(proc, now);
+
+      if (proc->edf_throttled)
+      {
+         proc->edf_throttled = 0;
+         if (proc->status == READY)
+         {
+            edf_enqueue(proc);
+         }
+      }
+   }
+
+   if (cur->edf_period == 0)
+   {
+      return EdfList != NULL;
+   }
+   return cur->edf_left <= 0 ||
+          (EdfList != NULL && EdfList->edf_deadline < cur->edf_deadline);
+} /* edf_tick */
+
+
+/* --------------------------------------------------------------------------------
+   Priority round-robin policy (default).  There is one ReadyList per
+   priority and the running process is preempted once it has used its
+   adaptive quantum (see quantum_update(), BATCH_QUANTUM for a batch
+   process).  Inside a priority, processes run by rank (see rl_rank()) and
+   FIFO within a rank.  A process preempted with part of its quantum left
+   goes back to the front of its rank.
+
+   Processes are queued by effective priority.  A process that has been
+   READY for AGE_INTERVAL without running moves up one level, and it drops
+   back to its base priority once it is picked.  AgeList keeps each level
+   in arrival order apart from the run order, so its head has waited
+   longest and aging only looks at one process per level.
+   --------------------------------------------------------------------------------*/
+static void prio_init(void)
+{
+   int prio;
+   int rank;
+
+   for (prio = 0; prio <= LOWEST_PRIORITY; prio++)
+   {
+      ReadyList[prio] = NULL;
+      AgeList[prio] = NULL;
+      AgeTail[prio] = NULL;
+      for (rank = 0; rank < RL_RANKS; rank++)
+      {
+         RankTail[prio][rank] = NULL;
+      }
+   }
+   ready_mask = 0;
+} /* prio_init */
+
+
+static void prio_fork(proc_ptr proc)
+{
+   proc->eff_priority = proc->priority;
+} /* prio_fork */
+
+
+/* A process that just became READY goes behind the others of its rank,
+ * so ahead of the ones it would preempt, see short_first().
+ */
+static void prio_enqueue(proc_ptr proc)
+{
+   insertRL(proc);
+} /* prio_enqueue */
+
+
+/* proc is about to run, so it loses any priority it gained by waiting,
+ * but keeps what it inherits from processes waiting on it.
+ */
+static void prio_dequeue(proc_ptr proc)
+{
+   removeFromRL(proc);
+   proc->eff_priority = top_priority(proc);
+} /* prio_dequeue */
+
+
+/* Keep the running process while it outranks the ReadyList, or ties with
+ * it and still has slice left; round-robin only happens within a priority.
+ * A batch process gives up a tie to interactive work.
+ */
+static proc_ptr prio_pick_next(proc_ptr cur)
+{
+   proc_ptr best = ready_best();
+
+   if (cur != NULL && cur->status == RUNNING &&
+       (best == NULL || cur->eff_priority < best->eff_priority ||
+        (cur->eff_priority == best->eff_priority && slice_remaining(cur) > 0 &&
+         !prio_preempt(best, cur))))
+   {
+      return cur;
+   }
+   return best;
+} /* prio_pick_next */
+
+
+/* Raise the longest waiting process of each level by one, if it is due.
+ * The sentinel's level does not age.
+ */
+static void prio_age(void)
+{
+   int prio;
+   int now = sys_clock();
+   proc_ptr proc;
+
+   for (prio = HIGHEST_PRIORITY + 1; prio < LOWEST_PRIORITY; prio++)
+   {
+      proc = AgeList[prio];
+      if (proc != NULL && now - proc->ready_since >= AGE_INTERVAL)
+      {
+         removeFromRL(proc);
+         proc->eff_priority = prio - 1;
+         insertRL(proc);
+      }
+   }
+} /* prio_age */
+
+
+static int prio_tick(proc_ptr cur)
+{
+   proc_ptr best;
+
+   prio_age();
+   best = ready_best();
+   return slice_remaining(cur) <= 0 ||
+          (best != NULL && prio_preempt(best, cur));
+} /* prio_tick */
+
+
+/* Within a priority, interactive work goes before a batch process, and a
+ * process whose quantum shrank below QUANTUM because it blocks early goes
+ * before one that uses its slices.
+ */
+static int short_first(proc_ptr proc, proc_ptr other)
+{
+   return rl_rank(proc) < rl_rank(other);
+} /* short_first */
+
+
+static int prio_preempt(proc_ptr woken, proc_ptr cur)
+{
+   if (woken->eff_priority != cur->eff_priority)
+   {
+      return woken->eff_priority < cur->eff_priority;
+   }
+   return short_first(woken, cur);
+} /* prio_preempt */
+
+
+/* proc has to beat the head outright, or be queued ahead of it. */
+static int prio_first(proc_ptr proc)
+{
+   proc_ptr best = ready_best();
+
+   return best == NULL || proc->eff_priority < best->eff_priority ||
+          (proc->eff_priority == best->eff_priority &&
+           short_first(proc, best));
+} /* prio_first */
+
+
+static void prio_yield(proc_ptr proc)
+{
+   if (proc->slice_left > 0 && proc->pid != SENTINELPID)
+      insertRL_front(proc);
+   else
+      insertRL(proc);
+} /* prio_yield */
+
+
+/* The base or inherited priority of proc changed.  A READY process moves
+ * to the tail of its new list; aging starts over.
+ */
+static void prio_reprio(proc_ptr proc)
+{
+   if (proc->status == READY)
+   {
+      removeFromRL(proc);
+      proc->eff_priority = top_priority(proc);
+      insertRL(proc);
+   }
+   else
+   {
+      proc->eff_priority = top_priority(proc);
+   }
+} /* prio_reprio */
+
+
+/* Same as being queued and picked: proc drops any priority from aging. */
+static void prio_handoff(proc_ptr proc)
+{
+   proc->eff_priority = top_priority(proc);
+} /* prio_handoff */
+
+
+#ifdef CONFIG_SCHED_STRIDE
+/* --------------------------------------------------------------------------------
+   Stride scheduling policy.  Each process advances its pass by its stride
+   for every millisecond of cpu it uses; the READY process with the lowest
+   pass runs next, so cpu time is divided in proportion to tickets.  READY
+   processes sit in a min-heap on pass, the sentinel is kept aside and
+   only runs when the heap is empty.
+   --------------------------------------------------------------------------------*/
+static void stride_swap(int a, int b)
+{
+   proc_ptr tmp = StrideHeap[a];
+
+   StrideHeap[a] = StrideHeap[b];
+   StrideHeap[b] = tmp;
+   StrideHeap[a]->heap_index = a;
+   StrideHeap[b]->heap_index = b;
+} /* stride_swap */
+
+
+static void stride_sift_up(int i)
+{
+   while (i > 1 && StrideHeap[i]->pass < StrideHeap[i / 2]->pass)
+   {
+      stride_swap(i, i / 2);
+      i = i / 2;
+   }
+} /* stride_sift_up */
+
+
+static void stride_sift_down(int i)
+{
+   int child;
+
+   while ((child = 2 * i) <= stride_heap_size)
+   {
+      if (child < stride_heap_size &&
+          StrideHeap[child + 1]->pass < StrideHeap[child]->pass)
+      {
+         child++;
+      }
+      if (StrideHeap[i]->pass <= StrideHeap[child]->pass)
+      {
+         break;
+      }
+      stride_swap(i, child);
+      i = child;
+   }
+} /* stride_sift_down */
+
+
+/* Advance the pass of proc for the cpu it used since it was last charged. */
+static void stride_charge(proc_ptr proc)
+{
+   int cpu = proc_cpu(proc);
+   long long work;
+
+   work = (long long) proc->stride * (cpu - proc->pass_cpu) + proc->pass_rem;
+   proc->pass += work / 1000;
+   proc->pass_rem = work % 1000;
+   proc->pass_cpu = cpu;
+} /* stride_charge */
+
+
+static void stride_init(void)
+{
+   stride_heap_size = 0;
+   stride_idle = NULL;
+   global_pass = 0;
+} /* stride_init */
+
+
+static void stride_fork(proc_ptr proc)
+{
+   proc->stride = STRIDE1 / proc->tickets;
+   proc->pass = global_pass;
+   proc->pass_rem = 0;
+   proc->heap_index = 0;
+} /* stride_fork */
+
+
+static void stride_enqueue(proc_ptr proc)
+{
+   stride_clamp(proc);
+   stride_yield(proc);
+} /* stride_enqueue */
+
+
+/* A process that slept does not get credit for the time it was away. */
+static void stride_clamp(proc_ptr proc)
+{
+   if (proc->pass < global_pass)
+   {
+      proc->pass = global_pass;
+   }
+} /* stride_clamp */
+
+
+static void stride_dequeue(proc_ptr proc)
+{
+   int i = proc->heap_index;
+
+   if (proc == stride_idle || i == 0)
+   {
+      return;
+   }
+
+   stride_swap(i, stride_heap_size);
+   stride_heap_size--;
+   proc->heap_index = 0;
+   if (i <= stride_heap_size)
+   {
+      stride_sift_up(i);
+      stride_sift_down(i);
+   }
+
+   /* proc is about to run */
+   global_pass = proc->pass;
+} /* stride_dequeue */
+
+
+/* Keep the running process unless someone is behind it in pass. */
+static proc_ptr stride_pick_next(proc_ptr cur)
+{
+   if (cur != NULL && cur != stride_idle)
+   {
+      stride_charge(cur);
+   }
+
+   if (stride_heap_size == 0)
+   {
+      if (cur != NULL && cur->status == RUNNING)
+      {
+         return cur;
+      }
+      return stride_idle;
+   }
+
+   if (cur != NULL && cur != stride_idle && cur->status == RUNNING &&
+       cur->pass <= StrideHeap[1]->pass)
+   {
+      return cur;
+   }
+   return StrideHeap[1];
+} /* stride_pick_next */
+
+
+/* Shares are settled every clock tick, not at slice ends: a whole slice,
+ * which the adaptive quantum can stretch to MAX_QUANTUM, is too coarse a
+ * unit for the shares to converge over a run of a few seconds.
+ */
+static int stride_tick(proc_ptr cur)
+{
+   if (cur == stride_idle)
+   {
+      return stride_heap_size > 0;
+   }
+
+   stride_charge(cur);
+   return stride_heap_size > 0 && StrideHeap[1]->pass < cur->pass;
+} /* stride_tick */
+
+
+/* Shares are settled at clock ticks, so a wakeup only preempts the sentinel. */
+static int stride_preempt(proc_ptr woken, proc_ptr cur)
+{
+   return cur == stride_idle;
+} /* stride_preempt */
+
+
+/* Leave the order to the heap unless nobody else is waiting. */
+static int stride_first(proc_ptr proc)
+{
+   return stride_heap_size == 0;
+} /* stride_first */
+
+
+static void stride_yield(proc_ptr proc)
+{
+   if (proc->pid == SENTINELPID)
+   {
+      stride_idle = proc;
+      return;
+   }
+
+   stride_heap_size++;
+   StrideHeap[stride_heap_size] = proc;
+   proc->heap_index = stride_heap_size;
+   stride_sift_up(stride_heap_size);
+} /* stride_yield */
+
+
+/* Shares come from tickets, so the heap does not change. */
+static void stride_reprio(proc_ptr proc)
+{
+} /* stride_reprio */
+
+
+static void stride_handoff(proc_ptr proc)
+{
+   stride_clamp(proc);
+   global_pass = proc->pass;
+} /* stride_handoff */
+#endif /* CONFIG_SCHED_STRIDE */
+
+
+#ifdef CONFIG_SCHED_FAIR
+/* --------------------------------------------------------------------------------
+   Hierarchical fair-share policy.  Every child of start1 leads a group made
+   of its whole subtree (see fork1_attr()).  A group and each process in it
+   advance a virtual time by the cpu microseconds they use, and the READY
+   process with the lowest time in the group with the lowest time runs
+   next, so the cpu is split evenly between groups first and then between
+   the members of each group.  READY processes sit in an unordered array
+   that is scanned on each pick, which is cheap at MAXPROC entries; the
+   sentinel is kept aside as in the stride policy.
+   --------------------------------------------------------------------------------*/
+
+/* Nonzero if a should run before b. */
+static int fair_before(proc_ptr a, proc_ptr b)
+{
+   if (a->group->group_pass != b->group->group_pass)
+   {
+      return a->group->group_pass < b->group->group_pass;
+   }
+   return a->pass < b->pass;
+} /* fair_before */
+
+
+static proc_ptr fair_best(void)
+{
+   int i;
+   proc_ptr best = NULL;
+
+   for (i = 0; i < fair_nready; i++)
+   {
+      if (best == NULL || fair_before(FairReady[i], best))
+      {
+         best = FairReady[i];
+      }
+   }
+   return best;
+} /* fair_best */
+
+
+/* Advance proc and its group for the cpu proc used since it was last charged. */
+static void fair_charge(proc_ptr proc)
+{
+   int cpu = proc_cpu(proc);
+
+   proc->pass += cpu - proc->pass_cpu;
+   proc->group->group_pass += cpu - proc->pass_cpu;
+   proc->pass_cpu = cpu;
+} /* fair_charge */
+
+
+static void fair_init(void)
+{
+   fair_nready = 0;
+   fair_idle = NULL;
+   fair_floor = 0;
+} /* fair_init */
+
+
+/* A new member starts level with its parent, a new group with the others. */
+static void fair_fork(proc_ptr proc)
+{
+   if (proc->group == proc)
+   {
+      proc->group_pass = fair_floor;
+      proc->pass = 0;
+   }
+   else
+   {
+      proc->pass = Current->pass;
+   }
+   proc->heap_index = 0;
+} /* fair_fork */
+
+
+static void fair_enqueue(proc_ptr proc)
+{
+   fair_clamp(proc);
+   fair_yield(proc);
+} /* fair_enqueue */
+
+
+/* Neither a process nor a group gets credit for the time it was away. */
+static void fair_clamp(proc_ptr proc)
+{
+   int i;
+   int active = 0;
+   long long floor = 0;
+   proc_ptr other;
+
+   for (i = 0; i <= fair_nready; i++)
+   {
+      other = i < fair_nready ? FairReady[i] : Current;
+      if (other == NULL || other == proc || other->group != proc->group ||
+          (other == Current && other->status != RUNNING))
+      {
+         continue;
+      }
+      if (!active || other->pass < floor)
+      {
+         floor = other->pass;
+      }
+      active = 1;
+   }
+
+   if (active)
+   {
+      if (proc->pass < floor)
+         proc->pass = floor;
+   }
+   else if (proc->group->group_pass < fair_floor)
+   {
+      proc->group->group_pass = fair_floor;
+   }
+} /* fair_clamp */
+
+
+static void fair_dequeue(proc_ptr proc)
+{
+   int i = proc->heap_index;
+
+   if (proc == fair_idle || i == 0)
+   {
+      return;
+   }
+
+   fair_nready--;
+   FairReady[i - 1] = FairReady[fair_nready];
+   FairReady[i - 1]->heap_index = i;
+   proc->heap_index = 0;
+
+   /* proc is about to run */
+   fair_floor = proc->group->group_pass;
+} /* fair_dequeue */
+
+
+/* Keep the running process until its slice is used and someone is ahead of it. */
+static proc_ptr fair_pick_next(proc_ptr cur)
+{
+   proc_ptr best;
+
+   if (cur != NULL && cur != fair_idle)
+   {
+      fair_charge(cur);
+   }
+
+   best = fair_best();
+   if (best == NULL)
+   {
+      if (cur != NULL && cur->status == RUNNING)
+      {
+         return cur;
+      }
+      return fair_idle;
+   }
+
+   if (cur != NULL && cur != fair_idle && cur->status == RUNNING &&
+       (slice_remaining(cur) > 0 || !fair_before(best, cur)))
+   {
+      return cur;
+   }
+   return best;
+} /* fair_pick_next */
+
+
+static int fair_tick(proc_ptr cur)
+{
+   proc_ptr best = fair_best();
+
+   if (cur == fair_idle)
+   {
+      return best != NULL;
+   }
+
+   fair_charge(cur);
+   return slice_remaining(cur) <= 0 && best != NULL && fair_before(best, cur);
+} /* fair_tick */
+
+
+/* Shares are settled at slice ends, so a wakeup only preempts the sentinel. */
+static int fair_preempt(proc_ptr woken, proc_ptr cur)
+{
+   return cur == fair_idle;
+} /* fair_preempt */
+
+
+static int fair_first(proc_ptr proc)
+{
+   return fair_nready == 0;
+} /* fair_first */
+
+
+static void fair_yield(proc_ptr proc)
+{
+   if (proc->pid == SENTINELPID)
+   {
+      fair_idle = proc;
+      return;
+   }
+
+   FairReady[fair_nready] = proc;
+   fair_nready++;
+   proc->heap_index = fair_nready;
+} /* fair_yield */
+
+
+/* Shares do not depend on priority. */
+static void fair_reprio(proc_ptr proc)
+{
+} /* fair_reprio */
+
+
+static void fair_handoff(proc_ptr proc)
+{
+   fair_clamp(proc);
+   fair_floor = proc->group->group_pass;
+} /* fair_handoff */
+#endif /* CONFIG_SCHED_FAIR */
+
+
+/* --------------------------------------------------------------------------------
+   Name - dump_shares
+   Purpose - Prints the target cpu share of each runnable process, from
+             its tickets, next to the share it actually got, from pc_time.
+   --------------------------------------------------------------------------------*/
+void dump_shares(void)
+{
+   int i;
+   int cpu;
+   int total_tickets = 0;
+   int total_cpu = 0;
+
+   for (i = 0; i < MAXPROC; i++)
+   {
+      if (ProcTable[i].pid == 0 || ProcTable[i].pid == SENTINELPID ||
+          ProcTable[i].status == QUIT || ProcTable[i].status == BLOCKED)
+      {
+         continue;
+      }
+      total_tickets += ProcTable[i].tickets;
+      total_cpu += ProcTable[i].pc_time;
+   }
+   total_cpu += sys_clock() - Current->start_time;
+
+   console("\n%-8s%-8s%-10s%-12s%-12s\n", "PID:", "Name:", "Tickets:",
+           "Target %:", "Achieved %:");
+   for (i = 0; i < MAXPROC; i++)
+   {
+      if (ProcTable[i].pid == 0 || ProcTable[i].pid == SENTINELPID ||
+          ProcTable[i].status == QUIT || ProcTable[i].status == BLOCKED)
+      {
+         continue;
+      }
+      cpu = ProcTable[i].pc_time;
+      if (&ProcTable[i] == Current)
+      {
+         cpu += sys_clock() - Current->start_time;
+      }
+      console("%-8d%-8s%-10d%-12.1f%-12.1f\n", ProcTable[i].pid,
+              ProcTable[i].name, ProcTable[i].tickets,
+              total_tickets ? 100.0 * ProcTable[i].tickets / total_tickets : 0.0,
+              total_cpu ? 100.0 * cpu / total_cpu : 0.0);
+   }
+} /* dump_shares */
+
+
+/* ------------------------------------------------------------------------
+   Name - dump_groups
+   Purpose - Prints the cpu used by each process group (a child of start1
+             and its subtree) next to the cpu of its leader, with the
+             number of times the group ran out of quota and the
+             milliseconds it spent parked.
+   Parameters - none
+   Returns - nothing
+   Side Effects - none
+   ----------------------------------------------------------------------- */
+void dump_groups(void)
+{
+   int i, j;
+   int members;
+   int total_cpu = 0;
+
+   for (i = 0; i < MAXPROC; i++)
+   {
+      if (ProcTable[i].pid != 0 && ProcTable[i].pid != SENTINELPID &&
+          ProcTable[i].group == &ProcTable[i])
+      {
+         total_cpu += group_time(ProcTable[i].pid);
+      }
+   }
+
+   console("\n%-8s%-8s%-10s%-12s%-12s%-12s%-12s%-12s\n", "PID:", "Name:",
+           "Members:", "CPU:", "Group CPU:", "Group %:", "Throttles:",
+           "Throttled:");
+   for (i = 0; i < MAXPROC; i++)
+   {
+      if (ProcTable[i].pid == 0 || ProcTable[i].pid == SENTINELPID ||
+          ProcTable[i].group != &ProcTable[i])
+      {
+         continue;
+      }
+      members = 0;
+      for (j = 0; j < MAXPROC; j++)
+      {
+         if (ProcTable[j].pid != 0 && ProcTable[j].status != QUIT &&
+             ProcTable[j].group == &ProcTable[i])
+         {
+            members++;
+         }
+      }
+      console("%-8d%-8s%-10d%-12d%-12d%-12.1f%-12d%-12d\n", ProcTable[i].pid,
+              ProcTable[i].name, members, proc_cpu(&ProcTable[i]) / 1000,
+              group_time(ProcTable[i].pid),
+              total_cpu ? 100.0 * group_time(ProcTable[i].pid) / total_cpu
+                        : 0.0,
+              ProcTable[i].throttle_events,
+              (ProcTable[i].throttled_time +
+               (ProcTable[i].throttled ? sys_clock() - ProcTable[i].throttle_since
+                                       : 0)) / 1000);
+   }
+} /* dump_groups */
+
+
+/* ------------------------------------------------------------------------
+   Name - group_time
+   Purpose - cpu used by the whole group of a process, the group
+             counterpart of readtime().
+   Parameters - pid of any process in the group
+   Returns - milliseconds, or -1 if pid is not in the process table
+   Side Effects - none
+   ----------------------------------------------------------------------- */
+int group_time(int pid)
+{
+   int i;
+
+   for (i = 0; i < MAXPROC; i++)
+   {
+      if (ProcTable[i].pid == pid && pid != 0)
+      {
+         return group_usage(ProcTable[i].group) / 1000;
+      }
+   }
+   return -1;
+} /* group_time */
+
+
+/* Total cpu microseconds used by the group led by group, including the
+ * current run.
+ */
+static int group_usage(proc_ptr group)
+{
+   int cpu = group->group_cpu;
+
+   if (Current != NULL && Current->group == group)
+   {
+      cpu += sys_clock() - Current->start_time;
+   }
+   return cpu;
+} /* group_usage */
+
+
+/* ------------------------------------------------------------------------
+   Name - dump_profile
+   Purpose - Prints the flat profile of the clock-tick samples, busiest
+             process first.  finish() calls it when anything was sampled.
+   Parameters - none
+   Returns - nothing
+   Side Effects - none
+   ----------------------------------------------------------------------- */
+void dump_profile(void)
+{
+   proc_ptr order[MAXPROC];
+   proc_ptr proc;
+   int count = 0;
+   int i, j;
+
+   /* insertion sort of the sampled processes by ticks, descending */
+   for (i = 0; i < MAXPROC; i++)
+   {
+      proc = &ProcTable[i];
+      if (proc->pid == 0 || proc->prof_ticks == 0)
+      {
+         continue;
       }
-       
-      console("%-16d", ProcTable[i].num_kids);
-      console("%-17d", ProcTable[i].start_time); 
-
-      switch(ProcTable[i].status)
+      for (j = count; j > 0 && order[j - 1]->prof_ticks < proc->prof_ticks; j--)
       {
-         case READY:
-            console("%-16s", "READY");
-            break;
-         case BLOCKED:
-            console("BLOCKED");
-            break;
-         case RUNNING:
-            console("%-16s", "RUNNING");
-            break;
-         case QUIT:
-            console("QUIT");
-            break;
-         default:
-            console("-1\t");
+         order[j] = order[j - 1];
       }
-      console("\n");
+      order[j] = proc;
+      count++;
    }
-} /* dump_processes */
 
+   console("\nFlat profile, %d ticks:\n", prof_total);
+   console("%-10s%-10s%-8s%-8s\n", "% time:", "Ticks:", "PID:", "Name:");
+   for (i = 0; i < count; i++)
+   {
+      console("%-10.1f%-10d%-8d%-8s\n",
+              100.0 * order[i]->prof_ticks / prof_total,
+              order[i]->prof_ticks, order[i]->pid, order[i]->name);
+   }
+} /* dump_profile */
 
-/* -------------------------------------------------------------------------------
-   Name - insertRL
-   Purpose - inserts entries into the ReadyList in appropriate order by priority
-   Parameters - a process pointer to a PCB block
-   -------------------------------------------------------------------------------*/
-static void insertRL(proc_ptr proc)
+
+/* ------------------------------------------------------------------------
+   Name - set_group_quota
+   Purpose - Caps the cpu a process group may use in each period.  A group
+             that reaches its quota is parked off the ready queues by
+             clock_handler() and released in one batch when the next
+             period begins.  Real-time members keep their own budget and
+             are not parked.
+   Parameters - pid of any process in the group, the quota and the period
+                in milliseconds; a quota of 0 removes the cap
+   Returns - 0 on success, -1 if pid is not a live process other than
+             the sentinel or the quota is negative or longer than the period
+   Side Effects - starts a new quota period for the group
+   ----------------------------------------------------------------------- */
+int set_group_quota(int pid, int quota_ms, int period_ms)
 {
-   proc_ptr walker, previous;  //pointers to PCB
-   previous = NULL;
-   walker = ReadyList;
-   while (walker != NULL && walker->priority <= proc->priority) {
-      previous = walker;
-      walker = walker->next_proc_ptr;
+   int i;
+   proc_ptr group = NULL;
+
+   mode_checker("set_group_quota()");
+
+   for (i = 0; i < MAXPROC; i++)
+   {
+      if (ProcTable[i].pid == pid && pid != 0 && pid != SENTINELPID &&
+          ProcTable[i].status != QUIT)
+      {
+         group = ProcTable[i].group;
+         break;
+      }
    }
-   if (previous == NULL) {
-      /* process goes at front of ReadyList */
-      proc->next_proc_ptr = ReadyList;
-      ReadyList = proc;
+   if (group == NULL || quota_ms < 0 ||
+       (quota_ms > 0 && (period_ms <= 0 || quota_ms > period_ms)))
+   {
+      return -1;
    }
-   else {
-      /* process goes after previous */
-      previous->next_proc_ptr = proc;
-      proc->next_proc_ptr = walker;
+
+   for (i = 0; i < quota_ngroups && QuotaGroups[i] != group; i++)
+      ;
+
+   if (quota_ms == 0)
+   {
+      if (i < quota_ngroups)
+      {
+         QuotaGroups[i] = QuotaGroups[--quota_ngroups];
+         group->quota = 0;
+         if (group->throttled && quota_release(group))
+         {
+            dispatcher();
+         }
+      }
+      return 0;
    }
-   return;
-} /* insertRL */
+
+   if (i == quota_ngroups)
+   {
+      QuotaGroups[quota_ngroups++] = group;
+   }
+   group->quota = quota_ms * 1000;
+   group->quota_period = period_ms * 1000;
+   group->quota_start = sys_clock();
+   group->quota_base = group_usage(group);
+   return 0;
+} /* set_group_quota */
 
 
 /* --------------------------------------------------------------------------------
-   Name - removeFromRL
-   Purpose - removes entry from the ReadyList
-   Parameters - Accepts a PID of the process to be removed
+   Name - quota_tick
+   Purpose - Called every clock tick.  Starts new quota periods, releasing
+             the groups parked in the last one, and parks the group of
+             Current once it has used up its quota.
+   Parameters - none
+   Returns - nonzero if the dispatcher should run
    --------------------------------------------------------------------------------*/
-static void removeFromRL(int PID)
+static int quota_tick(void)
 {
-   proc_ptr walker, tmp;
-   walker = ReadyList;
-   tmp = walker;
+   int i;
+   int now = sys_clock();
+   int resched = 0;
+   int over;
+   proc_ptr group;
 
-   /* if sentinel is the only process in the ready list, don't do anything */
-   if(walker->next_proc_ptr == NULL)
+   for (i = 0; i < quota_ngroups; i++)
    {
-      return;
+      group = QuotaGroups[i];
+      if (now - group->quota_start >= group->quota_period)
+      {
+         /* the group is only checked once a tick, so whatever it ran past
+          * its quota is charged to the new period
+          */
+         over = group_usage(group) - group->quota_base - group->quota;
+         group->quota_start = now - (now - group->quota_start) % group->quota_period;
+         group->quota_base = group_usage(group) - (over > 0 ? over : 0);
+         if (group->throttled && quota_release(group))
+         {
+            resched = 1;
+         }
+      }
    }
 
-   /* if process is the first item in the ready list */
-   if(walker->pid == PID)
+   group = Current->group;
+   if (group->quota != 0 && !group->throttled && Current->status == RUNNING &&
+       Current->edf_period == 0 &&
+       group_usage(group) - group->quota_base >= group->quota)
    {
-      ReadyList = walker->next_proc_ptr;
-      walker->next_proc_ptr = NULL;
-      return;
+      quota_throttle(group);
+      resched = 1;
    }
+   return resched;
+} /* quota_tick */
+
 
-   /* if process is somewhere else in the ready list, walk through the list */
-   while (walker != NULL && walker->pid != PID)
+/* Parks every member of group, Current included, that is not real-time. */
+static void quota_throttle(proc_ptr group)
+{
+   int i;
+   proc_ptr proc;
+
+   group->throttled = 1;
+   group->throttle_events++;
+   group->throttle_since = sys_clock();
+
+   for (i = 0; i < MAXPROC; i++)
    {
-      tmp = walker;
-      walker = walker->next_proc_ptr;
+      proc = &ProcTable[i];
+      if (proc->pid == 0 || proc->group != group || proc->edf_period != 0)
+      {
+         continue;
+      }
+      if (proc->status == READY)
+      {
+         sched_dequeue(proc);
+         proc->stats.ready_time += sys_clock() - proc->stat_since;
+         proc->stat_since = sys_clock();
+      }
+      if (proc->status == READY || proc->status == RUNNING)
+      {
+         block_proc(proc, THROTTLE_BLOCK);
+         proc->stats.throttles++;
+      }
    }
-   if (walker->pid == PID)
+} /* quota_throttle */
+
+
+/* Puts every parked member of group back on the ready queues at once.
+ * Returns nonzero if one of them should preempt Current.
+ */
+static int quota_release(proc_ptr group)
+{
+   int i;
+   int resched = 0;
+   proc_ptr proc;
+
+   group->throttled = 0;
+   group->throttled_time += sys_clock() - group->throttle_since;
+
+   for (i = 0; i < MAXPROC; i++)
    {
-      tmp->next_proc_ptr = walker->next_proc_ptr;
-      walker->next_proc_ptr = NULL;
-      return;
+      proc = &ProcTable[i];
+      if (proc->pid != 0 && proc->group == group &&
+          proc->status == BLOCKED && proc->blocked_status == THROTTLE_BLOCK)
+      {
+         wake_proc(proc);
+         sched_enqueue(proc);
+         if (wakeup_preempt(proc))
+         {
+            resched = 1;
+         }
+      }
    }
-   return;
-} /* removeFromRL */
+   return resched;
+} /* quota_release */
+
+
+/* --------------------------------------------------------------------------------
+   Name - deadline_misses
+   Purpose - returns how many periods of a real-time process ended before
+             it got its budget, or -1 if pid is not a real-time process.
+   --------------------------------------------------------------------------------*/
+int deadline_misses(int pid)
+{
+   int i;
+
+   for (i = 0; i < MAXPROC; i++)
+   {
+      if (ProcTable[i].pid == pid && ProcTable[i].edf_period != 0)
+      {
+         return ProcTable[i].deadline_misses;
+      }
+   }
+   return -1;
+} /* deadline_misses */
 
 
 /* ------------------------------------------------------------------------------------
@@ -817,8 +3372,7 @@ int block_me(int new_status)
    }
 
    /* Normal block the calling process. */
-   Current->status = BLOCKED;
-   Current->blocked_status = new_status;
+   block_proc(Current, new_status);
    return 0;
 } /* block_me */
 
@@ -851,25 +3405,434 @@ int unblock_proc(int pid)
       }
    }
 
-   ProcTable[i].status = READY;
-   insertRL(&ProcTable[i]);
-   dispatcher();
+   wake_proc(&ProcTable[i]);
+   sched_enqueue(&ProcTable[i]);
+   if (wakeup_preempt(&ProcTable[i]))
+   {
+      dispatcher();
+   }
 
    /* return 0 if unblock is sucessful. */
    return 0;
 } /* unblock_proc */
 
 
+/* Makes a BLOCKED process READY and starts timing its wakeup latency.
+ * A process released from a quota throttle was not waiting on anything,
+ * so that counts as throttled time rather than as a wakeup.  The caller
+ * puts it on the ready queues or switches to it.
+ */
+static void wake_proc(proc_ptr proc)
+{
+   int now = sys_clock();
+
+   if (is_throttled(proc))
+   {
+      proc->stats.throttled_time += now - proc->stat_since;
+   }
+   else
+   {
+      proc->stats.blocked_time += now - proc->stat_since;
+      proc->stats.wakeups++;
+      proc->woken = 1;
+   }
+   proc->status = READY;
+   nr_running++;
+   RUN_HOOKS(HOOK_UNBLOCK, proc->pid, Current->pid);
+   proc->stat_since = now;
+} /* wake_proc */
+
+
+/* Makes proc BLOCKED for the reason why.  A process that zap() left marked
+ * BLOCKED while it kept running is already out of nr_running.
+ */
+static void block_proc(proc_ptr proc, int why)
+{
+   if (proc->status == READY || proc->status == RUNNING)
+      nr_running--;
+   proc->status = BLOCKED;
+   proc->blocked_status = why;
+   RUN_HOOKS(HOOK_BLOCK, proc->pid, why);
+} /* block_proc */
+
+
+/* Nonzero if proc is parked by its group's cpu quota. */
+static int is_throttled(proc_ptr proc)
+{
+   return proc->status == BLOCKED && proc->blocked_status == THROTTLE_BLOCK;
+} /* is_throttled */
+
+
+/* -------------------------------------------------------------------------------
+   Name - get_proc_stats
+   Purpose - Copies the scheduling statistics of a process, getrusage()
+             style.  The time it has spent in its current state so far is
+             included.
+   Parameters - pid of the process, and where to store its statistics
+   Returns - 0, or -1 if pid is not in the process table
+   -------------------------------------------------------------------------------*/
+int get_proc_stats(int pid, proc_stats *stats)
+{
+   int i;
+   proc_ptr proc;
+
+   for (i = 0; i < MAXPROC; i++)
+   {
+      if (ProcTable[i].pid == pid && pid != 0)
+      {
+         break;
+      }
+   }
+   if (i == MAXPROC)
+   {
+      return -1;
+   }
+
+   proc = &ProcTable[i];
+   *stats = proc->stats;
+   stats->cpu_time = proc_cpu(proc);
+   if (proc->status == READY)
+   {
+      stats->ready_time += sys_clock() - proc->stat_since;
+   }
+   else if (is_throttled(proc))
+   {
+      stats->throttled_time += sys_clock() - proc->stat_since;
+   }
+   else if (proc->status == BLOCKED)
+   {
+      stats->blocked_time += sys_clock() - proc->stat_since;
+   }
+   return 0;
+} /* get_proc_stats */
+
+
+/* Adds one value in microseconds to hist. */
+static void lat_record(lat_hist *hist, int usecs)
+{
+   int bucket = 0;
+
+   while (bucket < LAT_BUCKETS - 1 && (usecs >> bucket) != 0)
+   {
+      bucket++;
+   }
+   hist->buckets[bucket]++;
+   hist->count++;
+   if (hist->count == 1 || usecs < hist->min)
+   {
+      hist->min = usecs;
+   }
+   if (usecs > hist->max)
+   {
+      hist->max = usecs;
+   }
+} /* lat_record */
+
+
+/* -------------------------------------------------------------------------------
+   Name - get_latency
+   Purpose - Copies a latency histogram.  Priorities 1 to LOWEST_PRIORITY
+             give the time processes of that base priority waited READY
+             before they ran, measured from the moment they became READY;
+             0 gives the time dispatcher() took to pick the next process.
+   Parameters - the priority, or 0, and where to store the histogram
+   Returns - 0, or -1 if priority is out of range
+   -------------------------------------------------------------------------------*/
+int get_latency(int priority, lat_hist *hist)
+{
+   if (priority < 0 || priority > LOWEST_PRIORITY)
+   {
+      return -1;
+   }
+   *hist = priority == 0 ? DispatchTime : ReadyLatency[priority];
+   return 0;
+} /* get_latency */
+
+
+/* -------------------------------------------------------------------------------
+   Name - lat_percentile
+   Purpose - Estimates a percentile from a histogram by interpolating
+             inside the bucket it falls in, as if that bucket's values
+             were spread evenly over its range; the range is narrowed to
+             the smallest and largest values seen.
+   Parameters - the histogram and the percentile, 1 to 100
+   Returns - microseconds, 0 for an empty histogram
+   -------------------------------------------------------------------------------*/
+int lat_percentile(lat_hist *hist, int pct)
+{
+   int rank = (hist->count * pct + 99) / 100;
+   int seen = 0;
+   int bucket;
+   long long low, high;
+
+   if (hist->count == 0)
+   {
+      return 0;
+   }
+   if (rank < 1)
+   {
+      rank = 1;
+   }
+   for (bucket = 0; bucket < LAT_BUCKETS - 1; bucket++)
+   {
+      if (seen + hist->buckets[bucket] >= rank)
+      {
+         break;
+      }
+      seen += hist->buckets[bucket];
+   }
+
+   low = bucket == 0 ? 0 : 1LL << (bucket - 1);
+   high = bucket == 0 ? 0 : (1LL << bucket) - 1;
+   if (low < hist->min)
+      low = hist->min;
+   if (high > hist->max)
+      high = hist->max;
+   return low + (high - low) * (rank - seen) / hist->buckets[bucket];
+} /* lat_percentile */
+
+
+/* ------------------------------------------------------------------------
+   Name - dump_latency
+   Purpose - Prints p50, p99 and max of the READY wait of every priority
+             that ran anything, and of dispatcher() itself.
+   Parameters - none
+   Returns - nothing
+   Side Effects - none
+   ----------------------------------------------------------------------- */
+void dump_latency(void)
+{
+   int prio;
+
+   console("\n%-16s%-10s%-10s%-10s%-10s\n", "Latency (us):", "Samples:",
+           "p50:", "p99:", "Max:");
+   for (prio = HIGHEST_PRIORITY; prio <= LOWEST_PRIORITY; prio++)
+   {
+      if (ReadyLatency[prio].count == 0)
+      {
+         continue;
+      }
+      console("READY prio %-5d%-10d%-10d%-10d%-10d\n", prio,
+              ReadyLatency[prio].count,
+              lat_percentile(&ReadyLatency[prio], 50),
+              lat_percentile(&ReadyLatency[prio], 99),
+              ReadyLatency[prio].max);
+   }
+   console("%-16s%-10d%-10d%-10d%-10d\n", "dispatcher()", DispatchTime.count,
+           lat_percentile(&DispatchTime, 50), lat_percentile(&DispatchTime, 99),
+           DispatchTime.max);
+} /* dump_latency */
+
+
+/* Best of the base and inherited priority of proc. */
+static int top_priority(proc_ptr proc)
+{
+   return proc->inh_priority < proc->priority ? proc->inh_priority
+                                               : proc->priority;
+} /* top_priority */
+
+
+/* Priority a blocked waiter passes on to what it waits on. */
+static int lent_priority(proc_ptr waiter)
+{
+   return waiter->lends ? top_priority(waiter) : waiter->inh_priority;
+} /* lent_priority */
+
+
+/* Best priority proc inherits from the processes blocked waiting on it.
+ * The same rule holds for a parent in join() and a process in zap(): a
+ * waiter forked with the inherit attribute lends its own priority, any
+ * other waiter only passes on what it inherited itself.  Lending by default
+ * would let every child outrank the ones it forks and let a zap target run
+ * ahead of processes the zapper was written to wait behind.
+ */
+static int waiter_priority(proc_ptr proc)
+{
+   proc_ptr parent = proc->parent_ptr;
+   proc_ptr walker;
+   int best = NO_INHERIT;
+
+   if (parent != NULL && parent->status == BLOCKED &&
+       parent->blocked_status == JOIN_BLOCK)
+   {
+      best = lent_priority(parent);
+   }
+   for (walker = proc->zapped_by_ptr; walker != NULL;
+        walker = walker->next_zapper_ptr)
+   {
+      if (walker->status == BLOCKED && walker->blocked_status == ZAP_BLOCK &&
+          lent_priority(walker) < best)
+      {
+         best = lent_priority(walker);
+      }
+   }
+   return best;
+} /* waiter_priority */
+
+
+/* --------------------------------------------------------------------------------
+   Name - inherit_update
+   Purpose - recomputes the priority proc inherits from its waiters, requeues
+             it if that changed, and passes the change down the chain when
+             proc is itself waiting on others
+   Parameters - a process pointer to a PCB block
+   --------------------------------------------------------------------------------*/
+static void inherit_update(proc_ptr proc)
+{
+   int inherited;
+
+   if (proc->status == QUIT)
+   {
+      return;
+   }
+
+   inherited = waiter_priority(proc);
+   if (inherited == proc->inh_priority)
+   {
+      return;
+   }
+   proc->inh_priority = inherited;
+
+   /* real-time processes are ordered by deadline, not priority */
+   if (proc->edf_period == 0)
+   {
+      SCHED(reprio)(proc);
+   }
+   inherit_targets(proc);
+} /* inherit_update */
+
+
+/* Recomputes everything waiter may be waiting on, called whenever waiter
+ * blocks, wakes up or changes priority.
+ */
+static void inherit_targets(proc_ptr waiter)
+{
+   proc_ptr child;
+
+   for (child = waiter->child_proc_ptr; child != NULL;
+        child = child->next_sibling_ptr)
+   {
+      inherit_update(child);
+   }
+   if (waiter->zap_target != NULL)
+   {
+      inherit_update(waiter->zap_target);
+   }
+} /* inherit_targets */
+
+
+/* -------------------------------------------------------------------------------
+   Name - set_priority
+   Purpose - changes the priority of a process while it is alive.  A READY
+             process is moved to its new ready list in constant time, and
+             the dispatcher runs if the change lets another process
+             outrank Current.
+   Parameters - pid of the process and its new priority
+   Returns - 0 on success, -1 if pid is not a live process other than the
+             sentinel or priority is out of range
+   -------------------------------------------------------------------------------*/
+int set_priority(int pid, int priority)
+{
+   int i;
+   proc_ptr proc = NULL;
+
+   mode_checker("set_priority()");
+
+   if (priority < HIGHEST_PRIORITY || priority > LOWEST_PRIORITY ||
+       pid == SENTINELPID)
+   {
+      return -1;
+   }
+
+   for (i = 0; i < MAXPROC; i++)
+   {
+      if (ProcTable[i].pid == pid && ProcTable[i].status != QUIT)
+      {
+         proc = &ProcTable[i];
+         break;
+      }
+   }
+   if (proc == NULL)
+   {
+      return -1;
+   }
+
+   proc->priority = priority;
+
+   /* real-time processes are ordered by deadline, not priority */
+   if (proc->edf_period != 0)
+   {
+      inherit_targets(proc);
+      return 0;
+   }
+   SCHED(reprio)(proc);
+
+   /* a waiting process passes the change on to what it waits on */
+   inherit_targets(proc);
+
+   /* Current lowered itself below a READY process, or a READY process
+    * now outranks it
+    */
+   if ((proc == Current && sched_pick_next(Current) != Current) ||
+       (proc->status == READY && sched_preempt(proc, Current)))
+   {
+      dispatcher();
+   }
+   return 0;
+} /* set_priority */
+
+
+/* -------------------------------------------------------------------------------
+   Name - get_sched_stats
+   Purpose - copies the scheduler event counters and load averages into
+             *stats, all as of the same moment.
+   -------------------------------------------------------------------------------*/
+void get_sched_stats(sched_stats *stats)
+{
+   *stats = SchedStats;
+} /* get_sched_stats */
+
+
 /* -------------------------------------------------------------------------------
    Name - readtime
    Purpose - returns CPU time (in milliseconds) used by the current process.
    -------------------------------------------------------------------------------*/
 int readtime(void)
 {
-   return (sys_clock() - Current->start_time) / 1000;
+   return (Current->pc_time + sys_clock() - Current->start_time) / 1000;
 } /* readtime */
 
 
+/* Total cpu microseconds used by proc, including the current run. */
+static int proc_cpu(proc_ptr proc)
+{
+   if (proc == Current)
+   {
+      return proc->pc_time + sys_clock() - proc->start_time;
+   }
+   return proc->pc_time;
+} /* proc_cpu */
+
+
+/* Microseconds of its quantum the running process has left. */
+static int slice_remaining(proc_ptr proc)
+{
+   return proc->slice_left - (sys_clock() - proc->start_time);
+} /* slice_remaining */
+
+
+/* Moves the cpu time of the current run into pc_time and the quantum. */
+static void charge_slice(proc_ptr proc)
+{
+   int now = sys_clock();
+
+   proc->pc_time += now - proc->start_time;
+   proc->group->group_cpu += now - proc->start_time;
+   proc->slice_left -= now - proc->start_time;
+   proc->start_time = now;
+} /* charge_slice */
+
+
 /* ---------------------------------------------------------------------------------
    Name - mode_checker
    Purpose - Check the mode if mode is in user mode halt(1).
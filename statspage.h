@@ -0,0 +1,68 @@
+/* ------------------------------------------------------------------------
+   statspage.h
+
+   Layout of the live stats page.  stats_map() maps a file of this size
+   and clock_handler() rewrites it every tick; statstop or any other
+   process can map the same file read-only and watch the kernel run.
+
+   Writers bump seq to an odd value, update the page and bump it back to
+   even.  Readers copy the page with stats_snapshot(), which retries until
+   it sees the same even seq before and after the copy, so they never
+   block the kernel and never see a half-written page.
+   ------------------------------------------------------------------------ */
+#ifndef STATSPAGE_H
+#define STATSPAGE_H
+
+#include <string.h>
+
+#define STATS_MAGIC 0x50315350   /* "P1SP" */
+#define STATS_VERSION 1
+#define STATS_NSLOTS 50          /* process table slots published */
+#define STATS_NAMELEN 16         /* names are cut to this, with the NUL */
+
+typedef struct stats_slot stats_slot;
+
+struct stats_slot {
+   int            pid;               /* 0 for an empty slot */
+   int            parent;            /* pid of the parent, 0 for none */
+   int            status;            /* RUNNING, READY, BLOCKED or QUIT of kernel.h */
+   int            priority;          /* base priority */
+   int            cpu_time;          /* cpu used in microseconds */
+   char           name[STATS_NAMELEN];
+};
+
+typedef struct stats_page stats_page;
+
+struct stats_page {
+   int            magic;             /* STATS_MAGIC */
+   int            version;           /* STATS_VERSION */
+   volatile unsigned int seq;        /* odd while the kernel is writing */
+   int            time;              /* sys_clock() of the last update */
+   int            forks;             /* the global counters of sched_stats */
+   int            quits;
+   int            switches;
+   int            preemptions;
+   int            ticks;
+   int            idle_ticks;
+   int            load_avg[3];       /* fixed point, 1 << STATS_LOAD_SHIFT is 1.0 */
+   stats_slot     slots[STATS_NSLOTS];
+};
+
+#define STATS_LOAD_SHIFT 16
+
+/* Copies a consistent snapshot of *page into *copy. */
+static inline void stats_snapshot(volatile stats_page *page, stats_page *copy)
+{
+   unsigned int seq;
+
+   do
+   {
+      while ((seq = page->seq) & 1)
+         ;
+      __sync_synchronize();
+      memcpy(copy, (void *)page, sizeof(*copy));
+      __sync_synchronize();
+   } while (page->seq != seq);
+} /* stats_snapshot */
+
+#endif /* STATSPAGE_H */
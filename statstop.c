@@ -0,0 +1,123 @@
+/* ------------------------------------------------------------------------
+   statstop.c
+
+   top-like viewer for the live stats page of a running simulation.
+
+   usage: statstop file [interval_ms [count]]
+
+   Prints the page every interval_ms (default 1000) count times (default
+   until interrupted).  %CPU is the share of the cpu each process got
+   since the previous screen.
+   ------------------------------------------------------------------------ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "statspage.h"
+
+/* process status values of kernel.h */
+static char *status_names[] = {"RUNNING", "READY", "BLOCKED", "QUIT"};
+
+static void show(stats_page *now, stats_page *prev, int first);
+
+int main(int argc, char *argv[])
+{
+   int fd;
+   int interval = 1000;
+   int count = -1;
+   int shown;
+   volatile stats_page *page;
+   stats_page now, prev;
+
+   if (argc < 2 || argc > 4)
+   {
+      fprintf(stderr, "usage: %s file [interval_ms [count]]\n", argv[0]);
+      return 2;
+   }
+   if (argc > 2)
+      interval = atoi(argv[2]);
+   if (argc > 3)
+      count = atoi(argv[3]);
+
+   fd = open(argv[1], O_RDONLY);
+   if (fd < 0)
+   {
+      perror(argv[1]);
+      return 1;
+   }
+   page = mmap(NULL, sizeof(stats_page), PROT_READ, MAP_SHARED, fd, 0);
+   close(fd);
+   if (page == MAP_FAILED)
+   {
+      perror(argv[1]);
+      return 1;
+   }
+   if (page->magic != STATS_MAGIC || page->version != STATS_VERSION)
+   {
+      fprintf(stderr, "%s: not a version %d stats page\n", argv[1], STATS_VERSION);
+      return 1;
+   }
+
+   for (shown = 0; count < 0 || shown < count; shown++)
+   {
+      if (shown > 0)
+         usleep(interval * 1000);
+      stats_snapshot(page, &now);
+      if (count != 1)
+         printf("\033[H\033[J");
+      show(&now, &prev, shown == 0);
+      fflush(stdout);
+      prev = now;
+   }
+   return 0;
+} /* main */
+
+
+/* Prints one screen, the busiest processes first. */
+static void show(stats_page *now, stats_page *prev, int first)
+{
+   stats_slot *order[STATS_NSLOTS];
+   int elapsed = first ? 0 : now->time - prev->time;
+   int count = 0;
+   int i, j, k;
+   int cpu;
+   double pct;
+
+   printf("time %d.%03d s  load %.2f %.2f %.2f  ticks %d (%d idle)\n",
+          now->time / 1000000, now->time / 1000 % 1000,
+          (double)now->load_avg[0] / (1 << STATS_LOAD_SHIFT),
+          (double)now->load_avg[1] / (1 << STATS_LOAD_SHIFT),
+          (double)now->load_avg[2] / (1 << STATS_LOAD_SHIFT),
+          now->ticks, now->idle_ticks);
+   printf("forks %d  quits %d  switches %d  preemptions %d\n\n", now->forks,
+          now->quits, now->switches, now->preemptions);
+
+   for (i = 0; i < STATS_NSLOTS; i++)
+   {
+      if (now->slots[i].pid == 0)
+         continue;
+      for (j = count; j > 0 && order[j - 1]->cpu_time < now->slots[i].cpu_time; j--)
+         order[j] = order[j - 1];
+      order[j] = &now->slots[i];
+      count++;
+   }
+
+   printf("%-7s%-7s%-17s%-6s%-9s%-12s%s\n", "PID", "PPID", "NAME", "PRI",
+          "STATUS", "CPU (ms)", "%CPU");
+   for (i = 0; i < count; i++)
+   {
+      /* cpu since the last screen, if the slot still holds the same pid */
+      k = order[i] - now->slots;
+      cpu = order[i]->cpu_time;
+      if (!first && prev->slots[k].pid == order[i]->pid)
+         cpu -= prev->slots[k].cpu_time;
+      pct = elapsed > 0 ? 100.0 * cpu / elapsed : 0.0;
+
+      printf("%-7d%-7d%-17s%-6d%-9s%-12d%.1f\n", order[i]->pid,
+             order[i]->parent, order[i]->name, order[i]->priority,
+             order[i]->status >= 0 && order[i]->status <= 3
+                ? status_names[order[i]->status] : "?",
+             order[i]->cpu_time / 1000, pct);
+   }
+} /* show */
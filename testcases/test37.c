@@ -0,0 +1,60 @@
+/*
+ * Checks proportional cpu shares.  Three cpu bound children with 100, 200
+ * and 300 tickets spin side by side until a common deadline; the first
+ * child past it prints the target and achieved shares.  Run with
+ * PHASE1_SCHED=stride on a kernel built with SCHED=-DCONFIG_SCHED_STRIDE
+ * to see the shares follow the tickets.  Under the default policy they
+ * round-robin.
+ *
+ * Expected output (stride):
+ * start1(): started
+ * ...
+ * PID:    Name:   Tickets:  Target %:   Achieved %:
+ * 3       XXp1    100       16.7        ~17
+ * 4       XXp2    200       33.3        ~33
+ * 5       XXp3    300       50.0        ~50
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+#include "kernel.h"
+
+int XXp1(char *);
+int deadline, dumped = 0;
+
+int start1(char *arg)
+{
+  int status, pid, i;
+  proc_attr attr = {0};
+  char *names[] = {"XXp1", "XXp2", "XXp3"};
+
+  printf("start1(): started\n");
+  deadline = sys_clock() + 1500000;
+  for (i = 0; i < 3; i++) {
+    attr.tickets = 100 * (i + 1);
+    pid = fork1_attr(names[i], XXp1, names[i], USLOSS_MIN_STACK, 3, &attr);
+    printf("start1(): after fork of child %d with %d tickets\n",
+           pid, attr.tickets);
+  }
+  for (i = 0; i < 3; i++) {
+    pid = join(&status);
+    printf("start1(): exit status for child %d is %d\n", pid, status);
+  }
+  quit(0);
+  return 0;
+}
+
+int XXp1(char *arg)
+{
+  printf("%s(): started\n", arg);
+  while (sys_clock() < deadline)
+    ;
+  /* the first child to see the deadline reports while all still run */
+  if (!dumped) {
+    dumped = 1;
+    dump_shares();
+  }
+  quit(-3);
+  return 0;
+}
@@ -0,0 +1,71 @@
+/*
+ * Checks the real-time (EDF) class.  Two periodic processes are admitted
+ * next to a priority 1 cpu hog and must not miss deadlines; a third one
+ * that would push the cpu past 100% is rejected by admission control.
+ *
+ * Expected output:
+ * start1(): started
+ * start1(): fork of RT1 (200 ms, 60 ms) returned 3
+ * start1(): fork of RT2 (400 ms, 100 ms) returned 4
+ * start1(): fork of RT3 (100 ms, 60 ms) returned -1
+ * start1(): fork of hog returned 5
+ * ...
+ * start1(): RT1 deadline misses = 0
+ * start1(): RT2 deadline misses = 0
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+#include "kernel.h"
+
+int RT(char *), Hog(char *);
+int deadline;
+
+int start1(char *arg)
+{
+  int status, pid, i;
+  int pids[3];
+  proc_attr attr = {0};
+  int periods[] = {200, 400, 100};
+  int budgets[] = {60, 100, 60};
+  char *names[] = {"RT1", "RT2", "RT3"};
+
+  printf("start1(): started\n");
+  deadline = sys_clock() + 2000000;
+  for (i = 0; i < 3; i++) {
+    attr.period = periods[i];
+    attr.budget = budgets[i];
+    pid = fork1_attr(names[i], RT, names[i], USLOSS_MIN_STACK, 3, &attr);
+    printf("start1(): fork of %s (%d ms, %d ms) returned %d\n",
+           names[i], periods[i], budgets[i], pid);
+    pids[i] = pid;
+  }
+  pid = fork1("hog", Hog, "hog", USLOSS_MIN_STACK, 1);
+  printf("start1(): fork of hog returned %d\n", pid);
+  for (i = 0; i < 3; i++)
+    join(&status);
+  for (i = 0; i < 2; i++)
+    printf("start1(): %s deadline misses = %d\n", names[i],
+           deadline_misses(pids[i]));
+  quit(0);
+  return 0;
+}
+
+int RT(char *arg)
+{
+  while (sys_clock() < deadline)
+    ;
+  printf("%s(): done\n", arg);
+  quit(0);
+  return 0;
+}
+
+int Hog(char *arg)
+{
+  while (sys_clock() < deadline)
+    ;
+  printf("hog(): done\n");
+  quit(0);
+  return 0;
+}
@@ -0,0 +1,64 @@
+/*
+ * Checks the direct switch from a quitting child to its joining parent.
+ * start1 forks and joins a lower priority child twenty times; each time
+ * the child quits, start1 is the best process to run, so quit() should
+ * hand the cpu straight to it.  start1 then forks one more child and
+ * yields ten times before joining it.  The child ranks below start1, so
+ * each yield() should find start1 still the best pick and leave it
+ * running without a context switch.
+ *
+ * Expected output:
+ * start1(): started
+ * start1(): 20 fork/join rounds done
+ * start1(): <n> us per round
+ * start1(): join handoffs = 20
+ * start1(): 10 yields kept start1 running
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+#include "kernel.h"
+
+#define ROUNDS 20
+#define YIELDS 10
+
+int XXp1(char *);
+
+int start1(char *arg)
+{
+  int status, i, start;
+  sched_stats stats, after;
+
+  printf("start1(): started\n");
+  start = sys_clock();
+  for (i = 0; i < ROUNDS; i++) {
+    fork1("XXp1", XXp1, NULL, USLOSS_MIN_STACK, 3);
+    join(&status);
+  }
+  get_sched_stats(&stats);
+  printf("start1(): %d fork/join rounds done\n", ROUNDS);
+  printf("start1(): %d us per round\n", (sys_clock() - start) / ROUNDS);
+  printf("start1(): join handoffs = %d\n", stats.join_handoffs);
+
+  fork1("XXp1", XXp1, NULL, USLOSS_MIN_STACK, 3);
+  for (i = 0; i < YIELDS; i++)
+    yield();
+  get_sched_stats(&after);
+  if (after.switches - stats.switches == 0 &&
+      after.switches_avoided - stats.switches_avoided >= YIELDS)
+    printf("start1(): %d yields kept start1 running\n", YIELDS);
+  else
+    printf("start1(): yields switched %d times, avoided %d\n",
+           after.switches - stats.switches,
+           after.switches_avoided - stats.switches_avoided);
+  join(&status);
+  quit(0);
+  return 0;
+}
+
+int XXp1(char *arg)
+{
+  quit(-3);
+  return 0;
+}
@@ -0,0 +1,55 @@
+/*
+ * Checks priority aging.  A priority 5 worker is forked next to a
+ * priority 2 loop that spins for two seconds.  Without aging the worker
+ * only runs once the loop is done; with aging it climbs one level every
+ * AGE_INTERVAL it waits and gets the cpu while the loop is still going.
+ *
+ * Expected output:
+ * start1(): started
+ * Worker(): started while Loop() was still running
+ * Worker(): done
+ * Loop(): done
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+
+int Loop(char *), Worker(char *);
+int loop_done = 0;
+
+int start1(char *arg)
+{
+  int status;
+
+  printf("start1(): started\n");
+  fork1("Loop", Loop, NULL, USLOSS_MIN_STACK, 2);
+  fork1("Worker", Worker, NULL, USLOSS_MIN_STACK, 5);
+  join(&status);
+  join(&status);
+  quit(0);
+  return 0;
+}
+
+int Loop(char *arg)
+{
+  int start = sys_clock();
+
+  while (sys_clock() - start < 2000000)
+    ;
+  loop_done = 1;
+  printf("Loop(): done\n");
+  quit(-2);
+  return 0;
+}
+
+int Worker(char *arg)
+{
+  if (loop_done)
+    printf("Worker(): started after Loop() finished\n");
+  else
+    printf("Worker(): started while Loop() was still running\n");
+  printf("Worker(): done\n");
+  quit(-5);
+  return 0;
+}
@@ -0,0 +1,59 @@
+/*
+ * Checks set_priority().  start1 forks A at priority 4 and B at priority
+ * 3, then raises A to 2 so that A runs first once start1 joins.  A then
+ * raises B above itself, and B should preempt A at once.  Bad pids and
+ * priorities are rejected.
+ *
+ * Expected output:
+ * start1(): started
+ * start1(): set_priority(A, 2) returned 0
+ * start1(): set_priority(99, 2) returned -1
+ * start1(): set_priority(A, 0) returned -1
+ * A(): started
+ * A(): raising B to 1
+ * B(): started
+ * B(): done
+ * A(): done
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+#include "kernel.h"
+
+int A(char *), B(char *);
+int pid_b;
+
+int start1(char *arg)
+{
+  int status, pid_a;
+
+  printf("start1(): started\n");
+  pid_a = fork1("A", A, NULL, USLOSS_MIN_STACK, 4);
+  pid_b = fork1("B", B, NULL, USLOSS_MIN_STACK, 3);
+  printf("start1(): set_priority(A, 2) returned %d\n", set_priority(pid_a, 2));
+  printf("start1(): set_priority(99, 2) returned %d\n", set_priority(99, 2));
+  printf("start1(): set_priority(A, 0) returned %d\n", set_priority(pid_a, 0));
+  join(&status);
+  join(&status);
+  quit(0);
+  return 0;
+}
+
+int A(char *arg)
+{
+  printf("A(): started\n");
+  printf("A(): raising B to 1\n");
+  set_priority(pid_b, 1);
+  printf("A(): done\n");
+  quit(0);
+  return 0;
+}
+
+int B(char *arg)
+{
+  printf("B(): started\n");
+  printf("B(): done\n");
+  quit(0);
+  return 0;
+}
@@ -0,0 +1,88 @@
+/*
+ * Checks priority inheritance while start1 has a priority 3 hog Med ready.
+ * Sup (priority 2, forked with the inherit attribute) zaps Low2 (priority
+ * 5), which runs before Med.  Sup then joins J (priority 4), which forks
+ * Low (priority 5) and joins it, so Sup's priority passes through J to Low
+ * and both run before Med.  Without inheritance Med runs as soon as Sup
+ * blocks.  J quits with a child, so the run ends there.
+ *
+ * Expected output:
+ * start1(): started
+ * Sup(): started
+ * Sup(): zapping Low2
+ * Low2(): started
+ * Sup(): Med started = 0
+ * J(): started
+ * Low(): started
+ * J(): Med started = 0
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+#include "kernel.h"
+
+int Sup(char *), J(char *), Low(char *), Med(char *);
+int med_started = 0;
+
+int start1(char *arg)
+{
+  int status;
+  proc_attr attr = {0};
+
+  printf("start1(): started\n");
+  attr.inherit = 1;
+  fork1_attr("Sup", Sup, NULL, USLOSS_MIN_STACK, 2, &attr);
+  fork1("Med", Med, NULL, USLOSS_MIN_STACK, 3);
+  join(&status);
+  join(&status);
+  quit(0);
+  return 0;
+}
+
+int Sup(char *arg)
+{
+  int status, pid;
+
+  printf("Sup(): started\n");
+  pid = fork1("Low2", Low, "Low2", USLOSS_MIN_STACK, 5);
+  printf("Sup(): zapping Low2\n");
+  zap(pid);
+  printf("Sup(): Med started = %d\n", med_started);
+  fork1("J", J, NULL, USLOSS_MIN_STACK, 4);
+  join(&status);
+  quit(0);
+  return 0;
+}
+
+int J(char *arg)
+{
+  int status;
+
+  printf("J(): started\n");
+  fork1("Low", Low, "Low", USLOSS_MIN_STACK, 5);
+  join(&status);
+  printf("J(): Med started = %d\n", med_started);
+  quit(0);
+  return 0;
+}
+
+int Low(char *arg)
+{
+  printf("%s(): started\n", arg);
+  quit(0);
+  return 0;
+}
+
+int Med(char *arg)
+{
+  int start = sys_clock();
+
+  med_started = 1;
+  printf("Med(): started\n");
+  while (sys_clock() - start < 500000)
+    ;
+  printf("Med(): done\n");
+  quit(0);
+  return 0;
+}
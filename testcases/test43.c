@@ -0,0 +1,69 @@
+/*
+ * Checks the batch class.  Two batch workers at priority 3 each spin for
+ * 300 ms, less than BATCH_QUANTUM, so they run one after the other instead
+ * of round-robin.  B2 then forks an interactive process at its own
+ * priority, which preempts it at once.  B2 forked a child, so the run ends
+ * when it quits.
+ *
+ * Expected output:
+ * start1(): started
+ * B1(): started
+ * B1(): done
+ * B2(): started
+ * B2(): done
+ * B2(): forking I
+ * I(): started
+ * B2(): switches rt = 0, normal = 3, batch = 2
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+#include "kernel.h"
+
+int Batch(char *), I(char *);
+
+int start1(char *arg)
+{
+  int status;
+  proc_attr attr = {0};
+
+  printf("start1(): started\n");
+  attr.batch = 1;
+  fork1_attr("B1", Batch, "B1", USLOSS_MIN_STACK, 3, &attr);
+  fork1_attr("B2", Batch, "B2", USLOSS_MIN_STACK, 3, &attr);
+  join(&status);
+  join(&status);
+  quit(0);
+  return 0;
+}
+
+int Batch(char *arg)
+{
+  int start = sys_clock();
+  sched_stats stats;
+
+  printf("%s(): started\n", arg);
+  while (sys_clock() - start < 300000)
+    ;
+  printf("%s(): done\n", arg);
+
+  if (arg[1] == '2')
+  {
+    printf("B2(): forking I\n");
+    fork1("I", I, NULL, USLOSS_MIN_STACK, 3);
+    get_sched_stats(&stats);
+    printf("B2(): switches rt = %d, normal = %d, batch = %d\n",
+           stats.class_switches[CLASS_RT], stats.class_switches[CLASS_NORMAL],
+           stats.class_switches[CLASS_BATCH]);
+  }
+  quit(0);
+  return 0;
+}
+
+int I(char *arg)
+{
+  printf("I(): started\n");
+  quit(0);
+  return 0;
+}
@@ -0,0 +1,84 @@
+/*
+ * Benchmarks cooperative mode against the preemptive default.  Three
+ * priority 3 workers each burn 400 ms of cpu.  With preemption they are
+ * switched every QUANTUM; in cooperative mode they call yield() after each
+ * 200 ms chunk.  The number of context switches and the completion time of
+ * each run are printed; the cooperative run should switch less often and
+ * finish the workers in the order they were forked.
+ *
+ * Expected output:
+ * start1(): started
+ * start1(): preemptive: <n> switches, <n> ms
+ * start1(): cooperative: <n> switches, <n> ms
+ * start1(): cooperative run finished W1 W2 W3
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <usloss.h>
+#include <phase1.h>
+#include "kernel.h"
+
+#define WORK  400
+#define CHUNK 200
+
+int Worker(char *);
+int cooperative = 0;
+char order[16];
+
+static int switches(void)
+{
+  sched_stats stats;
+
+  get_sched_stats(&stats);
+  return stats.class_switches[CLASS_RT] + stats.class_switches[CLASS_NORMAL] +
+         stats.class_switches[CLASS_BATCH];
+}
+
+static void run(char *mode)
+{
+  int status, start, before;
+
+  before = switches();
+  start = sys_clock();
+  fork1("W1", Worker, "W1", USLOSS_MIN_STACK, 3);
+  fork1("W2", Worker, "W2", USLOSS_MIN_STACK, 3);
+  fork1("W3", Worker, "W3", USLOSS_MIN_STACK, 3);
+  join(&status);
+  join(&status);
+  join(&status);
+  console("start1(): %s: %d switches, %d ms\n", mode, switches() - before,
+          (sys_clock() - start) / 1000);
+}
+
+int start1(char *arg)
+{
+  printf("start1(): started\n");
+  run("preemptive");
+  set_preemption(0);
+  cooperative = 1;
+  order[0] = '\0';
+  run("cooperative");
+  printf("start1(): cooperative run finished%s\n", order);
+  quit(0);
+  return 0;
+}
+
+int Worker(char *arg)
+{
+  int start = readtime();
+  int chunk = start;
+
+  while (readtime() - start < WORK)
+  {
+    if (cooperative && readtime() - chunk >= CHUNK)
+    {
+      yield();
+      chunk = readtime();
+    }
+  }
+  strcat(order, " ");
+  strcat(order, arg);
+  quit(0);
+  return 0;
+}
@@ -0,0 +1,62 @@
+/*
+ * Checks hierarchical fair share.  Group A is a child of start1 that forks
+ * four cpu bound workers, group B is a single cpu bound child of start1.
+ * Everyone spins until a common deadline and the first worker past it
+ * prints the group usage.  Run with PHASE1_SCHED=fair on a kernel built
+ * with SCHED=-DCONFIG_SCHED_FAIR to see the two groups split the cpu
+ * evenly; under the default policy group A gets about four fifths.
+ *
+ * Expected output (fair):
+ * start1(): started
+ * ...
+ * PID:    Name:   Members:  CPU:        Group CPU:  Group %:    Throttles:  Throttled:
+ * 2       start1  1         <n>         <n>         ~0          0           0
+ * 3       A       5         <n>         <n>         ~50         0           0
+ * 4       B       1         <n>         <n>         ~50         0           0
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+#include "kernel.h"
+
+int A(char *), Spin(char *);
+int deadline, dumped = 0;
+
+int start1(char *arg)
+{
+  int status;
+
+  printf("start1(): started\n");
+  deadline = sys_clock() + 1500000;
+  fork1("A", A, NULL, USLOSS_MIN_STACK, 3);
+  fork1("B", Spin, "B", USLOSS_MIN_STACK, 3);
+  join(&status);
+  join(&status);
+  quit(0);
+  return 0;
+}
+
+int A(char *arg)
+{
+  int status, i;
+
+  for (i = 0; i < 4; i++)
+    fork1("A-worker", Spin, "A-worker", USLOSS_MIN_STACK, 3);
+  for (i = 0; i < 4; i++)
+    join(&status);
+  quit(0);
+  return 0;
+}
+
+int Spin(char *arg)
+{
+  while (sys_clock() < deadline)
+    ;
+  if (!dumped) {
+    dumped = 1;
+    dump_groups();
+  }
+  quit(0);
+  return 0;
+}
@@ -0,0 +1,68 @@
+/*
+ * Checks group cpu quotas.  Two cpu bound children of start1 lead their
+ * own groups; A is capped at 60 ms of every 200 ms, B is not.  Both spin
+ * until a common deadline and the first one past it prints the group
+ * usage: A gets about 30% of the cpu and is throttled in most periods,
+ * B gets the rest.  A's own statistics count each throttle and the time
+ * it spent parked, not as blocked time or voluntary switches.  Bad quotas
+ * are rejected.
+ *
+ * Expected output:
+ * start1(): started
+ * start1(): set_group_quota(A, 60, 200) returned 0
+ * start1(): set_group_quota(A, 300, 200) returned -1
+ * start1(): set_group_quota(99, 60, 200) returned -1
+ * ...
+ * PID:    Name:   Members:  CPU:        Group CPU:  Group %:    Throttles:  Throttled:
+ * 2       start1  1         <n>         <n>         ~0          0           0
+ * 3       A       1         <n>         <n>         ~30         <n>         <n>
+ * 4       B       1         <n>         <n>         ~70         0           0
+ * A: throttles <n>, throttled <n> ms, blocked 0 ms, 0 voluntary switches
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+#include "kernel.h"
+
+int Spin(char *);
+int deadline, dumped = 0;
+
+int start1(char *arg)
+{
+  int status, pid;
+
+  printf("start1(): started\n");
+  deadline = sys_clock() + 1500000;
+  pid = fork1("A", Spin, NULL, USLOSS_MIN_STACK, 3);
+  fork1("B", Spin, NULL, USLOSS_MIN_STACK, 3);
+  printf("start1(): set_group_quota(A, 60, 200) returned %d\n",
+         set_group_quota(pid, 60, 200));
+  printf("start1(): set_group_quota(A, 300, 200) returned %d\n",
+         set_group_quota(pid, 300, 200));
+  printf("start1(): set_group_quota(99, 60, 200) returned %d\n",
+         set_group_quota(99, 60, 200));
+  join(&status);
+  join(&status);
+  quit(0);
+  return 0;
+}
+
+int Spin(char *arg)
+{
+  proc_stats stats;
+
+  while (sys_clock() < deadline)
+    ;
+  if (!dumped) {
+    dumped = 1;
+    dump_groups();
+    get_proc_stats(3, &stats);
+    printf("A: throttles %d, throttled %d ms, blocked %d ms, "
+           "%d voluntary switches\n", stats.throttles,
+           stats.throttled_time / 1000, stats.blocked_time / 1000,
+           stats.vol_switches);
+  }
+  quit(0);
+  return 0;
+}
@@ -0,0 +1,72 @@
+/*
+ * Checks adaptive quanta.  Hog spins until a deadline and always uses up
+ * its slice, so its quantum grows to MAX_QUANTUM.  Inter works for about a
+ * millisecond at a time and then blocks in join() on a short child, so its
+ * quantum shrinks to MIN_QUANTUM.  After ROUNDS rounds, which leave the
+ * process table a few slots to spare, Inter zaps Hog and prints the
+ * process table once Hog has quit.
+ *
+ * Expected output:
+ * start1(): started
+ * ...
+ * Entry:   Name:    PID:    Parent PID:      # of Children:  CPU time (ms):   Quantum (ms):  Status:
+ * ...
+ * 2        Hog      3        2               0               <n>              320             QUIT
+ * 3        Inter    4        2               0               <n>              20              RUNNING
+ * ...
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+#include "kernel.h"
+
+#define ROUNDS 44
+
+int Hog(char *), Inter(char *), Child(char *);
+int deadline, hog;
+
+int start1(char *arg)
+{
+  int status;
+
+  printf("start1(): started\n");
+  deadline = sys_clock() + 4000000;
+  hog = fork1("Hog", Hog, NULL, USLOSS_MIN_STACK, 3);
+  fork1("Inter", Inter, NULL, USLOSS_MIN_STACK, 3);
+  join(&status);
+  join(&status);
+  quit(0);
+  return 0;
+}
+
+int Hog(char *arg)
+{
+  while (sys_clock() < deadline)
+    ;
+  quit(0);
+  return 0;
+}
+
+int Inter(char *arg)
+{
+  int status, start, i;
+
+  for (i = 0; i < ROUNDS; i++) {
+    start = sys_clock();
+    while (sys_clock() - start < 1000)
+      ;
+    fork1("Child", Child, NULL, USLOSS_MIN_STACK, 3);
+    join(&status);
+  }
+  zap(hog);
+  dump_processes();
+  quit(0);
+  return 0;
+}
+
+int Child(char *arg)
+{
+  quit(0);
+  return 0;
+}
@@ -0,0 +1,67 @@
+/*
+ * Checks the scheduler trace.  start1 turns the trace on, forks Child and
+ * joins it.  The trace is then dumped to test48.trace and read back; times
+ * are left out of the output.
+ *
+ * Expected output:
+ * start1(): started
+ * Child(): started
+ * start1(): join returned 3, status -1
+ * trace_dump() wrote 6 records
+ * fork     3    2
+ * block    2    1
+ * switch   3    2
+ * unblock  2    3
+ * quit     3    -1
+ * switch   2    3
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+#include "kernel.h"
+#include "trace.h"
+
+static char *names[] = {"?", "fork", "switch", "block", "unblock", "zap",
+                        "quit"};
+
+int Child(char *);
+
+int start1(char *arg)
+{
+  int status, kidpid, count, i;
+  FILE *fp;
+  trace_header header;
+  trace_rec rec;
+
+  printf("start1(): started\n");
+  set_tracing(1);
+  fork1("Child", Child, NULL, USLOSS_MIN_STACK, 2);
+  kidpid = join(&status);
+  printf("start1(): join returned %d, status %d\n", kidpid, status);
+
+  count = trace_dump("test48.trace");
+  printf("trace_dump() wrote %d records\n", count);
+
+  fp = fopen("test48.trace", "rb");
+  if (fp == NULL || fread(&header, sizeof(header), 1, fp) != 1)
+  {
+    printf("start1(): cannot read test48.trace\n");
+    quit(1);
+  }
+  for (i = 0; i < header.count && fread(&rec, sizeof(rec), 1, fp) == 1; i++)
+  {
+    printf("%-9s%-5d%d\n", names[rec.event], rec.pid, rec.arg);
+  }
+  fclose(fp);
+
+  quit(0);
+  return 0;
+}
+
+int Child(char *arg)
+{
+  printf("Child(): started\n");
+  quit(-1);
+  return 0;
+}
@@ -0,0 +1,76 @@
+/*
+ * Checks the Chrome trace export.  start1 starts it with trace_json(),
+ * forks Child and joins it, then finishes the export and prints the file
+ * with the timestamps cut off.
+ *
+ * Expected output:
+ * start1(): started
+ * Child(): started
+ * start1(): join returned 3, status -1
+ * [
+ * {"name":"process_name","ph":"M","pid":1,"tid":0
+ * {"name":"thread_name","ph":"M","pid":1,"tid":3
+ * {"name":"fork","ph":"i","pid":1,"tid":3
+ * {"name":"join","ph":"i","pid":1,"tid":2
+ * {"name":"RUNNING","ph":"E","pid":1,"tid":2
+ * {"name":"RUNNING","ph":"B","pid":1,"tid":3
+ * {"name":"wakeup","ph":"i","pid":1,"tid":2
+ * {"name":"quit","ph":"i","pid":1,"tid":3
+ * {"name":"RUNNING","ph":"E","pid":1,"tid":3
+ * {"name":"RUNNING","ph":"B","pid":1,"tid":2
+ * ]
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <usloss.h>
+#include <phase1.h>
+#include "trace.h"
+
+int Child(char *);
+
+int start1(char *arg)
+{
+  int status, kidpid;
+  FILE *fp;
+  char line[256];
+  char *ts;
+
+  printf("start1(): started\n");
+  if (trace_json("test49.json") < 0)
+  {
+    printf("start1(): cannot write test49.json\n");
+    quit(1);
+  }
+  fork1("Child", Child, NULL, USLOSS_MIN_STACK, 2);
+  kidpid = join(&status);
+  printf("start1(): join returned %d, status %d\n", kidpid, status);
+  trace_json(NULL);
+
+  fp = fopen("test49.json", "r");
+  if (fp == NULL)
+  {
+    printf("start1(): cannot read test49.json\n");
+    quit(1);
+  }
+  while (fgets(line, sizeof(line), fp) != NULL)
+  {
+    ts = strstr(line, ",\"ts\":");
+    if (ts != NULL)
+    {
+      strcpy(ts, "\n");
+    }
+    printf("%s", line);
+  }
+  fclose(fp);
+
+  quit(0);
+  return 0;
+}
+
+int Child(char *arg)
+{
+  printf("Child(): started\n");
+  quit(-1);
+  return 0;
+}
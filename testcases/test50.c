@@ -0,0 +1,61 @@
+/*
+ * Checks the clock-tick profiler.  start1 turns it on and forks two cpu
+ * bound children of the same priority: Long spins for 900 ms and Short
+ * for 300 ms.  The flat profile printed at finish() gives Long about
+ * three times the ticks of Short.
+ *
+ * Expected output:
+ * start1(): started
+ * start1(): set_profiling(1) returned 0
+ * Short(): done
+ * Long(): done
+ * Flat profile, <n> ticks:
+ * % time:   Ticks:    PID:    Name:
+ * ~75       <n>       3       Long
+ * ~25       <n>       4       Short
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+#include "kernel.h"
+
+int Long(char *), Short(char *);
+
+static void spin(int usecs)
+{
+  int start = sys_clock();
+
+  while (sys_clock() - start < usecs)
+    ;
+}
+
+int start1(char *arg)
+{
+  int status;
+
+  printf("start1(): started\n");
+  printf("start1(): set_profiling(1) returned %d\n", set_profiling(1));
+  fork1("Long", Long, NULL, USLOSS_MIN_STACK, 3);
+  fork1("Short", Short, NULL, USLOSS_MIN_STACK, 3);
+  join(&status);
+  join(&status);
+  quit(0);
+  return 0;
+}
+
+int Long(char *arg)
+{
+  spin(900000);
+  printf("Long(): done\n");
+  quit(0);
+  return 0;
+}
+
+int Short(char *arg)
+{
+  spin(300000);
+  printf("Short(): done\n");
+  quit(0);
+  return 0;
+}
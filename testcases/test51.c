@@ -0,0 +1,81 @@
+/*
+ * Checks get_proc_stats().  start1 (pid 2) forks Child, which spins for
+ * 100 ms, and joins it, then zaps Target, which spins for 50 ms before it
+ * quits.  The counts are exact; the times are about what the spins take.
+ *
+ * Expected output:
+ * start1(): started
+ * Child: cpu ~100 ms, ready ~0 ms, blocked 0 ms
+ * Child: switches 1 voluntary, 0 involuntary, forks 0, zapped 0
+ * Target: cpu ~50 ms, zapped 1
+ * start1: cpu ~0 ms, ready ~0 ms, blocked ~150 ms
+ * start1: switches 2 voluntary, 0 involuntary, forks 2, zapped 0
+ * start1: wakeups 2, wake latency max ~0 ms
+ * get_proc_stats(99) returned -1
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+#include "kernel.h"
+
+int Child(char *), Target(char *);
+
+static void spin(int usecs)
+{
+  int start = sys_clock();
+
+  while (sys_clock() - start < usecs)
+    ;
+}
+
+int start1(char *arg)
+{
+  int status, pid;
+  proc_stats stats;
+
+  printf("start1(): started\n");
+  pid = fork1("Child", Child, NULL, USLOSS_MIN_STACK, 3);
+  join(&status);
+  get_proc_stats(pid, &stats);
+  printf("Child: switches %d voluntary, %d involuntary, forks %d, zapped %d\n",
+         stats.vol_switches, stats.invol_switches, stats.forks, stats.zapped);
+
+  pid = fork1("Target", Target, NULL, USLOSS_MIN_STACK, 3);
+  zap(pid);
+  get_proc_stats(pid, &stats);
+  printf("Target: cpu %d ms, zapped %d\n", stats.cpu_time / 1000,
+         stats.zapped);
+
+  get_proc_stats(2, &stats);
+  printf("start1: cpu %d ms, ready %d ms, blocked %d ms\n",
+         stats.cpu_time / 1000, stats.ready_time / 1000,
+         stats.blocked_time / 1000);
+  printf("start1: switches %d voluntary, %d involuntary, forks %d, zapped %d\n",
+         stats.vol_switches, stats.invol_switches, stats.forks, stats.zapped);
+  printf("start1: wakeups %d, wake latency max %d ms\n", stats.wakeups,
+         stats.max_wake_latency / 1000);
+  printf("get_proc_stats(99) returned %d\n", get_proc_stats(99, &stats));
+  quit(0);
+  return 0;
+}
+
+int Child(char *arg)
+{
+  proc_stats stats;
+
+  spin(100000);
+  get_proc_stats(3, &stats);
+  printf("Child: cpu %d ms, ready %d ms, blocked %d ms\n",
+         stats.cpu_time / 1000, stats.ready_time / 1000,
+         stats.blocked_time / 1000);
+  quit(0);
+  return 0;
+}
+
+int Target(char *arg)
+{
+  spin(50000);
+  quit(0);
+  return 0;
+}
@@ -0,0 +1,62 @@
+/*
+ * Checks the global counters and load averages.  start1 forks two cpu
+ * bound children that spin for two seconds and a third that quits at
+ * once, zaps the third and joins the other two.  With two processes runnable
+ * for two seconds the 1 s load average ends close to 2, the 5 s one
+ * around 0.7 and the 15 s one around 0.25.
+ *
+ * Expected output:
+ * start1(): started
+ * forks 5, quits 3, joins 2, zaps 1
+ * ticks ~100, idle 0, switches <n>, preemptions <n>
+ * load 1s ~1.7, 5s ~0.7, 15s ~0.25
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+#include "kernel.h"
+
+int Spin(char *), Quick(char *);
+
+int start1(char *arg)
+{
+  int status, pid;
+  sched_stats stats;
+
+  printf("start1(): started\n");
+  fork1("Spin", Spin, NULL, USLOSS_MIN_STACK, 3);
+  fork1("Spin", Spin, NULL, USLOSS_MIN_STACK, 3);
+  pid = fork1("Quick", Quick, NULL, USLOSS_MIN_STACK, 4);
+  zap(pid);
+  join(&status);
+  join(&status);
+
+  get_sched_stats(&stats);
+  printf("forks %d, quits %d, joins %d, zaps %d\n", stats.forks, stats.quits,
+         stats.joins, stats.zaps);
+  printf("ticks %d, idle %d, switches %d, preemptions %d\n", stats.ticks,
+         stats.idle_ticks, stats.switches, stats.preemptions);
+  printf("load 1s %.2f, 5s %.2f, 15s %.2f\n",
+         (double)stats.load_avg[0] / LOAD_FIXED_1,
+         (double)stats.load_avg[1] / LOAD_FIXED_1,
+         (double)stats.load_avg[2] / LOAD_FIXED_1);
+  quit(0);
+  return 0;
+}
+
+int Spin(char *arg)
+{
+  int start = sys_clock();
+
+  while (sys_clock() - start < 2000000)
+    ;
+  quit(0);
+  return 0;
+}
+
+int Quick(char *arg)
+{
+  quit(0);
+  return 0;
+}
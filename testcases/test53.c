@@ -0,0 +1,66 @@
+/*
+ * Checks the latency histograms.  start1 forks two cpu bound children of
+ * priority 3 that spin for 400 ms each and joins them.  Each waits about
+ * a quantum, rounded up to whole clock ticks, whenever the other holds
+ * the cpu, so most priority 3 waits are about 100 ms; the first runs
+ * after start1 blocks are much shorter.  start1 (priority 1) never waits
+ * long.  The percentiles are estimates inside a log bucket, but they are
+ * ordered and bounded by the exact min and max.  dump_latency() prints
+ * the same figures as a table.
+ *
+ * Expected output:
+ * start1(): started
+ * prio 1: samples 3, max under 1 ms
+ * prio 3: samples <n>, min <= p50 <= p99 <= max
+ * prio 3: min under 1 ms, p99 ~100 ms, max ~100 ms
+ * dispatcher(): samples <n>
+ * get_latency(7) returned -1
+ * ...
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+#include "kernel.h"
+
+int Spin(char *);
+
+int start1(char *arg)
+{
+  int status;
+  lat_hist hist;
+
+  printf("start1(): started\n");
+  fork1("Spin", Spin, NULL, USLOSS_MIN_STACK, 3);
+  fork1("Spin", Spin, NULL, USLOSS_MIN_STACK, 3);
+  join(&status);
+  join(&status);
+
+  get_latency(1, &hist);
+  printf("prio 1: samples %d, max %s\n", hist.count,
+         hist.max < 1000 ? "under 1 ms" : "1 ms or more");
+  get_latency(3, &hist);
+  printf("prio 3: samples %d, min %s p50 %s p99 %s max\n", hist.count,
+         hist.min <= lat_percentile(&hist, 50) ? "<=" : ">",
+         lat_percentile(&hist, 50) <= lat_percentile(&hist, 99) ? "<=" : ">",
+         lat_percentile(&hist, 99) <= hist.max ? "<=" : ">");
+  printf("prio 3: min %s, p99 %d ms, max %d ms\n",
+         hist.min < 1000 ? "under 1 ms" : "1 ms or more",
+         (lat_percentile(&hist, 99) + 500) / 1000, (hist.max + 500) / 1000);
+  get_latency(0, &hist);
+  printf("dispatcher(): samples %d\n", hist.count);
+  printf("get_latency(7) returned %d\n", get_latency(7, &hist));
+  dump_latency();
+  quit(0);
+  return 0;
+}
+
+int Spin(char *arg)
+{
+  int start = sys_clock();
+
+  while (sys_clock() - start < 400000)
+    ;
+  quit(0);
+  return 0;
+}
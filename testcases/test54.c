@@ -0,0 +1,71 @@
+/*
+ * Checks the dump_processes_fmt() modes.  Parent spins for 50 ms and
+ * forks Kid at a better priority; Kid spins for 100 ms and prints the
+ * process table as CSV, JSON and a tree.  The tree charges start1's
+ * subtree with the 150 ms its descendants used.
+ *
+ * Expected output:
+ * start1(): started
+ * slot,name,pid,parent,children,priority,cpu_ms,quantum_ms,status
+ * 0,sentinel,1,0,0,6,0,80,READY
+ * 1,start1,2,0,1,1,0,<q>,BLOCKED
+ * 2,Parent,3,2,1,3,~50,<q>,READY
+ * 3,Kid,4,3,0,2,~100,<q>,RUNNING
+ * {"processes": [
+ *   {"slot": 0, "name": "sentinel", "pid": 1, ... "status": "READY"},
+ *   ...
+ * ]}
+ *
+ * Name:                   PID:    CPU time (ms):  Subtree CPU (ms):   Status:
+ * sentinel                1       0               0                   READY
+ * start1                  2       0               ~150                BLOCKED
+ *   Parent                3       ~50             ~150                READY
+ *     Kid                 4       ~100            ~100                RUNNING
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+#include "kernel.h"
+
+int Parent(char *), Kid(char *);
+
+static void spin(int usecs)
+{
+  int start = sys_clock();
+
+  while (sys_clock() - start < usecs)
+    ;
+}
+
+int start1(char *arg)
+{
+  int status;
+
+  printf("start1(): started\n");
+  fork1("Parent", Parent, NULL, USLOSS_MIN_STACK, 3);
+  join(&status);
+  quit(0);
+  return 0;
+}
+
+int Parent(char *arg)
+{
+  int status;
+
+  spin(50000);
+  fork1("Kid", Kid, NULL, USLOSS_MIN_STACK, 2);
+  join(&status);
+  quit(0);
+  return 0;
+}
+
+int Kid(char *arg)
+{
+  spin(100000);
+  dump_processes_fmt(DUMP_CSV);
+  dump_processes_fmt(DUMP_JSON);
+  dump_processes_fmt(DUMP_TREE);
+  quit(0);
+  return 0;
+}
@@ -0,0 +1,80 @@
+/*
+ * Checks the live stats page.  start1 maps test55.stats and forks Spin,
+ * which spins for 200 ms and then reads the page back the way an outside
+ * reader would: mapped read-only and copied with stats_snapshot().  The
+ * page was last written by a clock tick during the spin.
+ *
+ * Expected output:
+ * start1(): started
+ * start1(): stats_map() returned 0, again -1
+ * Spin(): magic ok, seq even, ticks > 0
+ * Spin(): slot 0: pid 1, parent 0, priority 6, READY, sentinel
+ * Spin(): slot 1: pid 2, parent 0, priority 1, BLOCKED, start1
+ * Spin(): slot 2: pid 3, parent 2, priority 3, RUNNING, Spin
+ * Spin(): cpu of Spin at least 100 ms
+ */
+
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <usloss.h>
+#include <phase1.h>
+#include "kernel.h"
+#include "statspage.h"
+
+static char *status_names[] = {"RUNNING", "READY", "BLOCKED", "QUIT"};
+
+int Spin(char *);
+
+int start1(char *arg)
+{
+  int status, first;
+
+  printf("start1(): started\n");
+  first = stats_map("test55.stats");
+  printf("start1(): stats_map() returned %d, again %d\n", first,
+         stats_map("test55.stats"));
+  fork1("Spin", Spin, NULL, USLOSS_MIN_STACK, 3);
+  join(&status);
+  quit(0);
+  return 0;
+}
+
+int Spin(char *arg)
+{
+  int start = sys_clock();
+  int fd, i;
+  stats_page *page;
+  stats_page copy;
+
+  while (sys_clock() - start < 200000)
+    ;
+
+  fd = open("test55.stats", O_RDONLY);
+  page = mmap(NULL, sizeof(stats_page), PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (page == MAP_FAILED)
+  {
+    printf("Spin(): cannot map test55.stats\n");
+    quit(1);
+  }
+  stats_snapshot(page, &copy);
+  printf("Spin(): magic %s, seq %s, ticks %s\n",
+         copy.magic == STATS_MAGIC ? "ok" : "bad",
+         copy.seq % 2 == 0 ? "even" : "odd", copy.ticks > 0 ? "> 0" : "0");
+  for (i = 0; i < STATS_NSLOTS; i++)
+  {
+    if (copy.slots[i].pid != 0)
+    {
+      printf("Spin(): slot %d: pid %d, parent %d, priority %d, %s, %s\n", i,
+             copy.slots[i].pid, copy.slots[i].parent, copy.slots[i].priority,
+             status_names[copy.slots[i].status], copy.slots[i].name);
+    }
+  }
+  printf("Spin(): cpu of Spin %s\n", copy.slots[2].cpu_time >= 100000
+         ? "at least 100 ms" : "under 100 ms");
+  munmap(page, sizeof(stats_page));
+  quit(0);
+  return 0;
+}
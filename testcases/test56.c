@@ -0,0 +1,96 @@
+/*
+ * Checks the kernel hook registry.  start1 subscribes Count to every
+ * event, Once and Log to fork and Log to quit, forks Child and joins it,
+ * zaps Other, then unsubscribes and checks the error cases.  Once
+ * unsubscribes itself on its first call, which must not skip Log.  Log
+ * prints each call; Count's totals are printed at the end.
+ *
+ * Expected output:
+ * start1(): started
+ * start1(): register_hook() returned 0 0 0
+ * Once: fork pid 3
+ * Log: fork pid 3, arg 2
+ * Child(): started
+ * Log: quit pid 3, arg -1
+ * Log: fork pid 4, arg 2
+ * Other(): started
+ * Log: quit pid 4, arg -2
+ * Count: fork 2, switch 4, block 2, unblock 2, zap 1, quit 2
+ * start1(): register_hook(Log) again returned -1
+ * start1(): register_hook(7) returned -1
+ * start1(): unregister_hook() returned 0, again -1
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+#include "kernel.h"
+
+static char *names[] = {"?", "fork", "switch", "block", "unblock", "zap",
+                        "quit"};
+static int counts[HOOK_LAST + 1];
+
+int Child(char *), Other(char *);
+
+static void Count(int event, int pid, int arg)
+{
+  counts[event]++;
+}
+
+static void Once(int event, int pid, int arg)
+{
+  printf("Once: %s pid %d\n", names[event], pid);
+  unregister_hook(event, Once);
+}
+
+static void Log(int event, int pid, int arg)
+{
+  printf("Log: %s pid %d, arg %d\n", names[event], pid, arg);
+}
+
+int start1(char *arg)
+{
+  int status, pid, event, r1, r2, r3;
+
+  printf("start1(): started\n");
+  r1 = 0;
+  for (event = HOOK_FORK; event <= HOOK_LAST; event++)
+    r1 |= register_hook(event, Count);
+  r1 |= register_hook(HOOK_FORK, Once);
+  r2 = register_hook(HOOK_FORK, Log);
+  r3 = register_hook(HOOK_QUIT, Log);
+  printf("start1(): register_hook() returned %d %d %d\n", r1, r2, r3);
+
+  fork1("Child", Child, NULL, USLOSS_MIN_STACK, 3);
+  join(&status);
+  pid = fork1("Other", Other, NULL, USLOSS_MIN_STACK, 3);
+  zap(pid);
+
+  for (event = HOOK_FORK; event <= HOOK_LAST; event++)
+    unregister_hook(event, Count);
+  printf("Count: fork %d, switch %d, block %d, unblock %d, zap %d, quit %d\n",
+         counts[HOOK_FORK], counts[HOOK_SWITCH], counts[HOOK_BLOCK],
+         counts[HOOK_UNBLOCK], counts[HOOK_ZAP], counts[HOOK_QUIT]);
+  printf("start1(): register_hook(Log) again returned %d\n",
+         register_hook(HOOK_FORK, Log));
+  printf("start1(): register_hook(7) returned %d\n", register_hook(7, Count));
+  r1 = unregister_hook(HOOK_QUIT, Log);
+  r2 = unregister_hook(HOOK_QUIT, Log);
+  printf("start1(): unregister_hook() returned %d, again %d\n", r1, r2);
+  quit(0);
+  return 0;
+}
+
+int Child(char *arg)
+{
+  printf("Child(): started\n");
+  quit(-1);
+  return 0;
+}
+
+int Other(char *arg)
+{
+  printf("Other(): started\n");
+  quit(-2);
+  return 0;
+}
@@ -0,0 +1,80 @@
+/*
+ * Checks the wakeup preference for short quanta.  Hog spins at priority 3
+ * the whole time.  Inter, also priority 3, works for about a millisecond
+ * at a time and then blocks in join() on a short child.  Once its quantum
+ * has shrunk, neither the child nor Inter itself waits behind Hog when it
+ * becomes READY, so the last rounds take about a millisecond each and
+ * Inter is woken with next to no latency.  Inter quits with children, so
+ * the run ends there.
+ *
+ * Expected output:
+ * start1(): started
+ * Inter(): last 10 rounds took ~10 ms
+ * Inter(): 10 wakeups, average wake latency ~0 ms
+ */
+
+#include <stdio.h>
+#include <usloss.h>
+#include <phase1.h>
+#include "kernel.h"
+
+#define WARMUP 30
+#define ROUNDS 40
+
+int Hog(char *), Inter(char *), Child(char *);
+int inter;
+
+int start1(char *arg)
+{
+  int status;
+
+  printf("start1(): started\n");
+  fork1("Hog", Hog, NULL, USLOSS_MIN_STACK, 3);
+  inter = fork1("Inter", Inter, NULL, USLOSS_MIN_STACK, 3);
+  join(&status);
+  join(&status);
+  quit(0);
+  return 0;
+}
+
+int Hog(char *arg)
+{
+  while (1)
+    ;
+  quit(0);
+  return 0;
+}
+
+int Inter(char *arg)
+{
+  int status, start, i, began = 0;
+  proc_stats before, after;
+
+  for (i = 0; i < ROUNDS; i++) {
+    if (i == WARMUP) {
+      began = sys_clock();
+      get_proc_stats(inter, &before);
+    }
+    start = sys_clock();
+    while (sys_clock() - start < 1000)
+      ;
+    fork1("Child", Child, NULL, USLOSS_MIN_STACK, 3);
+    join(&status);
+  }
+  get_proc_stats(inter, &after);
+
+  printf("Inter(): last %d rounds took %d ms\n", ROUNDS - WARMUP,
+         (sys_clock() - began) / 1000);
+  printf("Inter(): %d wakeups, average wake latency %d ms\n",
+         after.wakeups - before.wakeups,
+         (after.wake_latency - before.wake_latency) /
+         (after.wakeups - before.wakeups) / 1000);
+  quit(0);
+  return 0;
+}
+
+int Child(char *arg)
+{
+  quit(0);
+  return 0;
+}
@@ -0,0 +1,72 @@
+/*
+ * Checks the choice of scheduling policy.  The policy running must be the
+ * one named by PHASE1_SCHED, or prio when it is not set.  prio is always
+ * built in, stride and fair only with their CONFIG_SCHED_ flag, and a
+ * name that is not a policy is refused.  A build with only prio calls it
+ * directly instead of through the sched_ops table.  start1 then forks a
+ * child to see that processes are scheduled under the chosen policy.
+ * With PHASE1_SCHED=nosuch the kernel halts in startup() instead:
+ * sched_init(): scheduling policy nosuch is not built in. Halting...
+ *
+ * Expected output, default build without PHASE1_SCHED:
+ * start1(): started
+ * start1(): running policy prio
+ * start1(): policy matches PHASE1_SCHED
+ * start1(): 1 policy built in, called directly
+ * start1(): built-in policies found, unknown name rejected
+ * XXp1(): started under prio
+ * start1(): XXp1 quit with -3
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <usloss.h>
+#include <phase1.h>
+#include "kernel.h"
+
+int XXp1(char *);
+
+int start1(char *arg)
+{
+  int status;
+  char *want = getenv("PHASE1_SCHED");
+
+  printf("start1(): started\n");
+  printf("start1(): running policy %s\n", sched_name());
+  if (want == NULL)
+    want = SCHED_DEFAULT;
+  if (strcmp(sched_name(), want) == 0)
+    printf("start1(): policy matches PHASE1_SCHED\n");
+  else
+    printf("start1(): policy %s, PHASE1_SCHED %s\n", sched_name(), want);
+
+  if (SCHED_NPOLICIES == 1)
+    printf("start1(): 1 policy built in, called directly\n");
+  else
+    printf("start1(): %d policies built in, called through sched_ops\n",
+           SCHED_NPOLICIES);
+
+  if (sched_available("prio") &&
+      sched_available("stride") == SCHED_HAVE_STRIDE &&
+      sched_available("fair") == SCHED_HAVE_FAIR &&
+      !sched_available("nosuch") && !sched_available(""))
+    printf("start1(): built-in policies found, unknown name rejected\n");
+  else
+    printf("start1(): prio %d, stride %d, fair %d, nosuch %d\n",
+           sched_available("prio"), sched_available("stride"),
+           sched_available("fair"), sched_available("nosuch"));
+
+  fork1("XXp1", XXp1, NULL, USLOSS_MIN_STACK, 3);
+  join(&status);
+  printf("start1(): XXp1 quit with %d\n", status);
+  quit(0);
+  return 0;
+}
+
+int XXp1(char *arg)
+{
+  printf("XXp1(): started under %s\n", sched_name());
+  quit(-3);
+  return 0;
+}
@@ -0,0 +1,328 @@
+/* ------------------------------------------------------------------------
+   trace.c
+
+   Ring buffer behind trace.h.  Recording an event is an index increment
+   and four stores; nothing is formatted until the file is decoded.
+
+   While a JSON export is open every event is also written out as it
+   happens, so long runs are not limited to what the ring holds.  Each
+   PID is a thread of one trace process: RUNNING slices come from the
+   switch events and the rest are instant events.
+
+   The sink of the tracepoints of tracepoint.h lives here too.
+   ------------------------------------------------------------------------ */
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <usloss.h>
+#include <phase1.h>
+#include "kernel.h"
+#include "trace.h"
+#include "tracepoint.h"
+
+static trace_rec TraceBuf[TRACE_SIZE];
+
+/* events recorded so far, the next one goes to TraceBuf[trace_next % TRACE_SIZE] */
+static unsigned int trace_next = 0;
+
+/* open JSON export, NULL when off */
+static FILE *json_fp = NULL;
+
+/* events written to json_fp, to know where commas go */
+static int json_count = 0;
+
+static void json_begin(char *ph, char *name, int pid, int time);
+static void json_record(trace_rec *rec);
+
+/* categories whose compiled-in tracepoints log, see set_tp_mask() */
+unsigned int tp_mask = TP_CAT_ALL;
+
+/* tracepoint output not yet written to the console */
+static char TpBuf[TP_BUF_SIZE];
+static int tp_len = 0;
+
+
+/* ------------------------------------------------------------------------
+   Name - trace_event
+   Purpose - Records one event, overwriting the oldest once the ring is full.
+   Parameters - TRACE_* event code, the pid it is about and an argument
+   Returns - nothing
+   ----------------------------------------------------------------------- */
+void trace_event(int event, int pid, int arg)
+{
+   trace_rec *rec = &TraceBuf[trace_next++ & (TRACE_SIZE - 1)];
+
+   rec->time = sys_clock();
+   rec->event = event;
+   rec->pid = pid;
+   rec->arg = arg;
+
+   if (json_fp != NULL)
+   {
+      json_record(rec);
+   }
+} /* trace_event */
+
+
+/* ------------------------------------------------------------------------
+   Name - trace_name
+   Purpose - Names the track of a new process in the JSON export.  The
+             binary trace only holds pids.
+   Parameters - pid and name of the process
+   Returns - nothing
+   ----------------------------------------------------------------------- */
+void trace_name(int pid, char *name)
+{
+   unsigned int psr = psr_get();
+
+   if (json_fp == NULL)
+   {
+      return;
+   }
+
+   psr_set(psr & ~PSR_CURRENT_INT);
+   json_begin("M", "thread_name", pid, 0);
+   fprintf(json_fp, ",\"args\":{\"name\":\"");
+   for (; *name != '\0'; name++)
+   {
+      if (*name == '"' || *name == '\\')
+      {
+         fputc('\\', json_fp);
+      }
+      fputc(*name, json_fp);
+   }
+   fprintf(json_fp, " (%d)\"}}", pid);
+   psr_set(psr);
+} /* trace_name */
+
+
+/* ------------------------------------------------------------------------
+   Name - trace_dump
+   Purpose - Writes the records still in the ring, oldest first, after a
+             trace_header.  The ring is left as it is.
+   Parameters - path of the file to create
+   Returns - number of records written, -1 if the file could not be written
+   ----------------------------------------------------------------------- */
+int trace_dump(char *path)
+{
+   FILE *fp;
+   trace_header header;
+   unsigned int first;
+   unsigned int i;
+
+   fp = fopen(path, "wb");
+   if (fp == NULL)
+   {
+      return -1;
+   }
+
+   memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+   header.version = TRACE_VERSION;
+   header.rec_size = sizeof(trace_rec);
+   header.count = trace_next < TRACE_SIZE ? trace_next : TRACE_SIZE;
+   header.total = trace_next;
+
+   first = trace_next - header.count;
+   if (fwrite(&header, sizeof(header), 1, fp) != 1)
+   {
+      fclose(fp);
+      return -1;
+   }
+   for (i = first; i != trace_next; i++)
+   {
+      if (fwrite(&TraceBuf[i & (TRACE_SIZE - 1)], sizeof(trace_rec), 1, fp) != 1)
+      {
+         fclose(fp);
+         return -1;
+      }
+   }
+
+   if (fclose(fp) != 0)
+   {
+      return -1;
+   }
+   return header.count;
+} /* trace_dump */
+
+
+/* ------------------------------------------------------------------------
+   Name - trace_json
+   Purpose - Starts or stops streaming events as Chrome Trace Event JSON,
+             which chrome://tracing and ui.perfetto.dev open directly.
+             Output goes through stdio buffering, so the export has to
+             be finished, as finish() does at halt(), to leave a complete
+             file.  Starting an export turns on set_tracing().
+   Parameters - path of the file to create, or NULL to finish the export
+   Returns - 0, or -1 if the file could not be opened or written
+   ----------------------------------------------------------------------- */
+int trace_json(char *path)
+{
+   int result = 0;
+
+   if (json_fp != NULL)
+   {
+      fprintf(json_fp, "\n]\n");
+      if (fclose(json_fp) != 0)
+      {
+         result = -1;
+      }
+      json_fp = NULL;
+   }
+   if (path == NULL)
+   {
+      return result;
+   }
+
+   json_fp = fopen(path, "w");
+   if (json_fp == NULL)
+   {
+      return -1;
+   }
+   json_count = 0;
+   set_tracing(1);
+   fprintf(json_fp, "[");
+   json_begin("M", "process_name", 0, 0);
+   fprintf(json_fp, ",\"args\":{\"name\":\"phase1\"}}");
+   return 0;
+} /* trace_json */
+
+
+/* Opens one event object up to its timestamp; the caller adds any args
+ * and the closing brace.
+ */
+static void json_begin(char *ph, char *name, int pid, int time)
+{
+   fprintf(json_fp, "%s\n{\"name\":\"%s\",\"ph\":\"%s\",\"pid\":1,"
+           "\"tid\":%d,\"ts\":%d", json_count++ == 0 ? "" : ",",
+           name, ph, pid, time);
+   if (ph[0] == 'i')
+   {
+      fprintf(json_fp, ",\"s\":\"t\"");
+   }
+} /* json_begin */
+
+
+/* Writes rec as the JSON events it stands for.  The clock interrupt is
+ * held off so a switch from the clock handler cannot land in the middle
+ * of another write to json_fp.
+ */
+static void json_record(trace_rec *rec)
+{
+   unsigned int psr = psr_get();
+
+   psr_set(psr & ~PSR_CURRENT_INT);
+   switch (rec->event)
+   {
+   case TRACE_FORK:
+      json_begin("i", "fork", rec->pid, rec->time);
+      fprintf(json_fp, "}");
+      break;
+   case TRACE_SWITCH:
+      if (rec->arg != 0)
+      {
+         json_begin("E", "RUNNING", rec->arg, rec->time);
+         fprintf(json_fp, "}");
+      }
+      json_begin("B", "RUNNING", rec->pid, rec->time);
+      fprintf(json_fp, "}");
+      break;
+   case TRACE_BLOCK:
+      /* a zap wait already shows as the zap itself */
+      if (rec->arg == JOIN_BLOCK)
+      {
+         json_begin("i", "join", rec->pid, rec->time);
+         fprintf(json_fp, "}");
+      }
+      else if (rec->arg != ZAP_BLOCK)
+      {
+         json_begin("i", "block", rec->pid, rec->time);
+         fprintf(json_fp, ",\"args\":{\"status\":%d}}", rec->arg);
+      }
+      break;
+   case TRACE_UNBLOCK:
+      json_begin("i", "wakeup", rec->pid, rec->time);
+      fprintf(json_fp, ",\"args\":{\"by\":%d}}", rec->arg);
+      break;
+   case TRACE_ZAP:
+      json_begin("i", "zap", rec->pid, rec->time);
+      fprintf(json_fp, ",\"args\":{\"target\":%d}}", rec->arg);
+      break;
+   case TRACE_QUIT:
+      json_begin("i", "quit", rec->pid, rec->time);
+      fprintf(json_fp, "}");
+      break;
+   }
+   psr_set(psr);
+} /* json_record */
+
+
+/* ------------------------------------------------------------------------
+   Name - tp_log
+   Purpose - Appends a tracepoint message to the buffer, first writing the
+             buffer out if the message does not fit.  The clock interrupt
+             is held off so a tracepoint in clock_handler() cannot land in
+             the middle of another one.
+   Parameters - printf style format and arguments
+   Returns - nothing
+   ----------------------------------------------------------------------- */
+void tp_log(char *fmt, ...)
+{
+   unsigned int psr = psr_get();
+   va_list args;
+   int n;
+
+   psr_set(psr & ~PSR_CURRENT_INT);
+   va_start(args, fmt);
+   n = vsnprintf(TpBuf + tp_len, sizeof(TpBuf) - tp_len, fmt, args);
+   va_end(args);
+   if (n >= (int)sizeof(TpBuf) - tp_len)
+   {
+      /* did not fit: flush what was there and format again */
+      TpBuf[tp_len] = '\0';
+      tp_flush();
+      va_start(args, fmt);
+      n = vsnprintf(TpBuf, sizeof(TpBuf), fmt, args);
+      va_end(args);
+   }
+   if (n > 0)
+   {
+      tp_len += n;
+      if (tp_len >= (int)sizeof(TpBuf))
+      {
+         tp_len = sizeof(TpBuf) - 1;
+      }
+   }
+   psr_set(psr);
+} /* tp_log */
+
+
+/* ------------------------------------------------------------------------
+   Name - tp_flush
+   Purpose - Writes the buffered tracepoint output with one console() call.
+   Parameters - none
+   Returns - nothing
+   ----------------------------------------------------------------------- */
+void tp_flush(void)
+{
+   if (tp_len > 0)
+   {
+      console("%s", TpBuf);
+      tp_len = 0;
+   }
+} /* tp_flush */
+
+
+/* ------------------------------------------------------------------------
+   Name - set_tp_mask
+   Purpose - Chooses which TP_CAT_* categories of the compiled-in
+             tracepoints log.
+   Parameters - the categories, or-ed together
+   Returns - the previous mask
+   ----------------------------------------------------------------------- */
+unsigned int set_tp_mask(unsigned int mask)
+{
+   unsigned int old = tp_mask;
+
+   tp_mask = mask;
+   return old;
+} /* set_tp_mask */
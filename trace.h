@@ -0,0 +1,50 @@
+/* ------------------------------------------------------------------------
+   trace.h
+
+   Binary scheduler trace.  Once set_tracing() subscribes trace_event() to
+   every kernel event, it records each one into a fixed-size ring that
+   overwrites the oldest entries; trace_dump()
+   writes the ring to a file that tracedump decodes offline.
+   trace_json() also streams every event as Chrome Trace Event JSON.
+   ------------------------------------------------------------------------ */
+#ifndef TRACE_H
+#define TRACE_H
+
+#define TRACE_SIZE 4096          /* records kept, a power of two */
+#define TRACE_MAGIC "P1TR"
+#define TRACE_VERSION 1
+
+/* event codes, with what pid and arg of the record hold */
+#define TRACE_FORK 1             /* pid forked, arg is its parent (0 for none) */
+#define TRACE_SWITCH 2           /* pid runs, arg was running (0 for none) */
+#define TRACE_BLOCK 3            /* pid blocked, arg is its blocked_status */
+#define TRACE_UNBLOCK 4          /* pid made READY, arg is the pid that did it */
+#define TRACE_ZAP 5              /* pid zapped arg */
+#define TRACE_QUIT 6             /* pid quit, arg is its exit code */
+
+typedef struct trace_rec trace_rec;
+
+struct trace_rec {
+   int            time;              /* sys_clock() in microseconds */
+   short          event;             /* TRACE_FORK ... */
+   short          pid;
+   int            arg;
+};
+
+/* start of a trace file, followed by count records oldest first */
+typedef struct trace_header trace_header;
+
+struct trace_header {
+   char           magic[4];          /* TRACE_MAGIC */
+   int            version;           /* TRACE_VERSION */
+   int            rec_size;          /* sizeof(trace_rec) */
+   int            count;             /* records in the file */
+   unsigned int   total;             /* events recorded, total - count were lost */
+};
+
+extern void trace_event(int event, int pid, int arg);
+extern void trace_name(int pid, char *name);
+extern int trace_dump(char *path);
+extern int trace_json(char *path);
+
+#endif /* TRACE_H */
@@ -0,0 +1,63 @@
+/* ------------------------------------------------------------------------
+   tracedump.c
+
+   Offline decoder for the files written by trace_dump().
+
+   usage: tracedump file
+   ------------------------------------------------------------------------ */
+#include <stdio.h>
+#include <string.h>
+#include "trace.h"
+
+static char *event_names[] = {"?", "fork", "switch", "block", "unblock",
+                              "zap", "quit"};
+
+int main(int argc, char *argv[])
+{
+   FILE *fp;
+   trace_header header;
+   trace_rec rec;
+   int i;
+   char *name;
+
+   if (argc != 2)
+   {
+      fprintf(stderr, "usage: %s file\n", argv[0]);
+      return 2;
+   }
+
+   fp = fopen(argv[1], "rb");
+   if (fp == NULL)
+   {
+      perror(argv[1]);
+      return 1;
+   }
+
+   if (fread(&header, sizeof(header), 1, fp) != 1 ||
+       memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) != 0 ||
+       header.version != TRACE_VERSION || header.rec_size != sizeof(trace_rec))
+   {
+      fprintf(stderr, "%s: not a version %d trace file\n", argv[1], TRACE_VERSION);
+      fclose(fp);
+      return 1;
+   }
+
+   printf("# %d records, %u events, %u lost\n", header.count, header.total,
+          header.total - header.count);
+   printf("%-12s%-10s%-8s%s\n", "time (us)", "event", "pid", "arg");
+   for (i = 0; i < header.count; i++)
+   {
+      if (fread(&rec, sizeof(rec), 1, fp) != 1)
+      {
+         fprintf(stderr, "%s: truncated after %d records\n", argv[1], i);
+         fclose(fp);
+         return 1;
+      }
+      name = rec.event > 0 && rec.event <= TRACE_QUIT ? event_names[rec.event]
+                                                      : event_names[0];
+      printf("%-12d%-10s%-8d%d\n", rec.time, name, rec.pid, rec.arg);
+   }
+
+   fclose(fp);
+   return 0;
+} /* main */
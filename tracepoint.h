@@ -0,0 +1,59 @@
+/* ------------------------------------------------------------------------
+   tracepoint.h
+
+   Compile-time tracepoints.  A tracepoint names a level and a category:
+
+      TP_INFO(TP_CAT_SCHED, "clock_handler(): calling dispatcher().\n");
+
+   Levels above TP_LEVEL (make TP=-DTP_LEVEL=3) expand to nothing, so the
+   default build carries no trace code at all.  Compiled-in tracepoints
+   still check tp_mask, which set_tp_mask() or PHASE1_TP_MASK change at
+   run time, and go to a buffer that is written to the console when it
+   fills, on tp_flush() and at finish().
+   ------------------------------------------------------------------------ */
+#ifndef TRACEPOINT_H
+#define TRACEPOINT_H
+
+#define TP_LEVEL_ERR 1           /* the kernel is about to halt */
+#define TP_LEVEL_INFO 2          /* scheduling decisions, startup steps */
+#define TP_LEVEL_DEBUG 3         /* every process start and hook call */
+
+#ifndef TP_LEVEL
+#define TP_LEVEL 0               /* highest level compiled in, 0 for none */
+#endif
+
+#define TP_CAT_BOOT 0x01         /* startup() and finish() */
+#define TP_CAT_PROC 0x02         /* fork1(), launch(), quit() */
+#define TP_CAT_SCHED 0x04        /* clock_handler(), dispatcher(), sentinel() */
+#define TP_CAT_HOOK 0x08         /* the p1_* hooks */
+#define TP_CAT_ALL 0x0f
+
+#define TP_BUF_SIZE 4096
+
+extern unsigned int tp_mask;
+extern void tp_log(char *fmt, ...);
+extern void tp_flush(void);
+extern unsigned int set_tp_mask(unsigned int mask);
+
+#define TP_LOG(cat, ...) \
+   do { if (tp_mask & (cat)) tp_log(__VA_ARGS__); } while (0)
+
+#if TP_LEVEL >= TP_LEVEL_ERR
+#define TP_ERR(cat, ...) TP_LOG(cat, __VA_ARGS__)
+#else
+#define TP_ERR(cat, ...) do { } while (0)
+#endif
+
+#if TP_LEVEL >= TP_LEVEL_INFO
+#define TP_INFO(cat, ...) TP_LOG(cat, __VA_ARGS__)
+#else
+#define TP_INFO(cat, ...) do { } while (0)
+#endif
+
+#if TP_LEVEL >= TP_LEVEL_DEBUG
+#define TP_DEBUG(cat, ...) TP_LOG(cat, __VA_ARGS__)
+#else
+#define TP_DEBUG(cat, ...) do { } while (0)
+#endif
+
+#endif /* TRACEPOINT_H */